@@ -0,0 +1,204 @@
+import 'dart:math' as math;
+import 'dart:ui';
+
+import 'package:desk_switch/core/input/input_message.dart';
+
+/// Short-horizon dead-reckoning predictor for the remote cursor.
+///
+/// Velocity is estimated from recent motion frames (exponentially smoothed)
+/// and the last known position is extrapolated [horizon] ahead, which hides
+/// roughly one network hop of latency. Whenever a new frame moves the
+/// trajectory, the jump between what was displayed and the new prediction
+/// is kept as an offset that decays with [correctionHalfLife], so errors are
+/// reconciled smoothly instead of snapping.
+class CursorPredictor {
+  CursorPredictor({
+    this.horizon = const Duration(milliseconds: 30),
+    this.maxExtrapolation = const Duration(milliseconds: 80),
+    this.correctionHalfLife = const Duration(milliseconds: 25),
+    this.velocitySmoothing = 0.5,
+  });
+
+  /// How far ahead of the last frame the cursor is rendered
+  final Duration horizon;
+
+  /// Stop extrapolating this long after the last motion frame
+  final Duration maxExtrapolation;
+
+  /// Half-life of the blend towards a corrected trajectory
+  final Duration correctionHalfLife;
+
+  /// Weight of the newest velocity sample, in `(0, 1]`
+  final double velocitySmoothing;
+
+  final PredictionStats stats = PredictionStats();
+
+  Offset? _position;
+  Offset _velocity = Offset.zero; // px per microsecond
+  int _lastArrivalUs = 0;
+  int _lastTimestampUs = 0;
+
+  Offset _blendOffset = Offset.zero;
+  int _blendStartUs = 0;
+
+  // Predictions waiting for the frame they tried to anticipate
+  final List<({int targetUs, Offset position})> _pending = [];
+
+  /// Whether there is a position to render
+  bool get hasPosition => _position != null;
+
+  /// Whether the cursor is still extrapolating or blending, i.e. whether the
+  /// caller should keep rendering frames
+  bool isSettling(int nowUs) =>
+      _velocity != Offset.zero &&
+          nowUs - _lastArrivalUs < maxExtrapolation.inMicroseconds ||
+      _blendOffset.distanceSquared *
+              math.pow(
+                0.25,
+                (nowUs - _blendStartUs) / correctionHalfLife.inMicroseconds,
+              ) >
+          0.25;
+
+  /// Feed a frame received from the server at local time [arrivalUs]
+  void addFrame(PointerFrame frame, int arrivalUs) {
+    final position = Offset(frame.x, frame.y);
+    final displayed = _position == null ? null : _displayed(arrivalUs);
+
+    _recordError(position, arrivalUs);
+
+    if (_position != null && frame.timestampUs > _lastTimestampUs) {
+      final dt = frame.timestampUs - _lastTimestampUs;
+      final sample = (position - _position!) / dt.toDouble();
+      // A correction is authoritative, so its sample replaces the estimate.
+      // One sent during motion shares the motion frame's timestamp and
+      // leaves the velocity alone; one sent after the pointer settled
+      // brings it to zero.
+      _velocity = frame.isCorrection
+          ? sample
+          : _velocity * (1 - velocitySmoothing) + sample * velocitySmoothing;
+    }
+
+    _position = position;
+    _lastArrivalUs = arrivalUs;
+    _lastTimestampUs = math.max(_lastTimestampUs, frame.timestampUs);
+
+    // Carry the visible discontinuity over and let it decay
+    if (displayed != null) {
+      _blendOffset = displayed - _extrapolate(arrivalUs);
+      _blendStartUs = arrivalUs;
+    }
+  }
+
+  /// Position to render at local time [nowUs]
+  Offset predict(int nowUs) {
+    final predicted = _displayed(nowUs);
+    _pending.add((targetUs: nowUs + horizon.inMicroseconds, position: predicted));
+    if (_pending.length > 64) {
+      _pending.removeAt(0);
+    }
+    return predicted;
+  }
+
+  /// Drop all state, e.g. when the connection or focus changes
+  void reset() {
+    _position = null;
+    _velocity = Offset.zero;
+    _blendOffset = Offset.zero;
+    _pending.clear();
+  }
+
+  Offset _displayed(int nowUs) {
+    final elapsed = nowUs - _blendStartUs;
+    final decay = math.pow(
+      0.5,
+      elapsed / correctionHalfLife.inMicroseconds,
+    ).toDouble();
+    return _extrapolate(nowUs) + _blendOffset * decay;
+  }
+
+  Offset _extrapolate(int nowUs) {
+    final position = _position ?? Offset.zero;
+    final ahead = math.min(
+      nowUs - _lastArrivalUs + horizon.inMicroseconds,
+      maxExtrapolation.inMicroseconds,
+    );
+    return position + _velocity * ahead.toDouble();
+  }
+
+  /// Compare the prediction made for [arrivalUs] with the actual position
+  void _recordError(Offset actual, int arrivalUs) {
+    ({int targetUs, Offset position})? closest;
+    for (final prediction in _pending) {
+      if (prediction.targetUs > arrivalUs) {
+        break;
+      }
+      closest = prediction;
+    }
+    if (closest == null) {
+      return;
+    }
+    _pending.removeWhere((p) => p.targetUs <= arrivalUs);
+    stats.add((closest.position - actual).distance);
+  }
+}
+
+/// Distribution of prediction errors in pixels
+class PredictionStats {
+  /// Upper bounds of the histogram buckets, in pixels
+  static const List<double> bucketBounds = [1, 2, 4, 8, 16, 32, 64];
+
+  final List<int> _buckets = List.filled(bucketBounds.length + 1, 0);
+  int _count = 0;
+  double _sum = 0;
+  double _max = 0;
+
+  int get count => _count;
+  double get mean => _count == 0 ? 0 : _sum / _count;
+  double get max => _max;
+
+  /// Histogram counts; the last bucket holds everything above 64 px
+  List<int> get buckets => List.unmodifiable(_buckets);
+
+  void add(double error) {
+    var index = bucketBounds.indexWhere((bound) => error <= bound);
+    if (index < 0) {
+      index = bucketBounds.length;
+    }
+    _buckets[index]++;
+    _count++;
+    _sum += error;
+    _max = math.max(_max, error);
+  }
+
+  /// Upper bound of the bucket containing the [q] quantile
+  double quantile(double q) {
+    if (_count == 0) {
+      return 0;
+    }
+    final target = (q * _count).ceil();
+    var seen = 0;
+    for (var i = 0; i < bucketBounds.length; i++) {
+      seen += _buckets[i];
+      if (seen >= target) {
+        return bucketBounds[i];
+      }
+    }
+    return _max;
+  }
+
+  /// Copy of the current distribution
+  PredictionStats snapshot() {
+    return PredictionStats()
+      .._buckets.setAll(0, _buckets)
+      .._count = _count
+      .._sum = _sum
+      .._max = _max;
+  }
+
+  void clear() {
+    _buckets.fillRange(0, _buckets.length, 0);
+    _count = 0;
+    _sum = 0;
+    _max = 0;
+  }
+}
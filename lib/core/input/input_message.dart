@@ -0,0 +1,174 @@
+import 'dart:typed_data';
+
+/// Message types carried on the input stream of the multiplexer.
+///
+/// The first byte of every input message is the index of its type.
+enum InputMessageType {
+  pointerMotion,
+  pointerCorrection,
+  scroll,
+  screenSize,
+  focus;
+
+  /// Peek at the type of an encoded input message
+  static InputMessageType? of(Uint8List data) =>
+      data.isEmpty ? null : values.elementAtOrNull(data[0]);
+}
+
+/// Absolute pointer position on the controlled machine's screen.
+///
+/// Motion frames are sent for every captured movement. Correction frames
+/// carry the server's authoritative position at a lower rate (and once when
+/// motion stops) so the client can reconcile its prediction.
+class PointerFrame {
+  const PointerFrame({
+    required this.type,
+    required this.sequence,
+    required this.timestampUs,
+    required this.x,
+    required this.y,
+  });
+
+  /// Decode a frame, returning `null` for other message types
+  static PointerFrame? decode(Uint8List data) {
+    final type = InputMessageType.of(data);
+    if (type != InputMessageType.pointerMotion &&
+            type != InputMessageType.pointerCorrection ||
+        data.length < encodedSize) {
+      return null;
+    }
+    final view = ByteData.sublistView(data);
+    return PointerFrame(
+      type: type!,
+      sequence: view.getUint32(1),
+      timestampUs: view.getInt64(5),
+      x: view.getFloat32(13),
+      y: view.getFloat32(17),
+    );
+  }
+
+  static const int encodedSize = 21;
+
+  final InputMessageType type;
+  final int sequence;
+
+  /// Capture time on the server, in microseconds
+  final int timestampUs;
+  final double x;
+  final double y;
+
+  bool get isCorrection => type == InputMessageType.pointerCorrection;
+
+  Uint8List encode() {
+    final data = Uint8List(encodedSize);
+    ByteData.sublistView(data)
+      ..setUint8(0, type.index)
+      ..setUint32(1, sequence)
+      ..setInt64(5, timestampUs)
+      ..setFloat32(13, x)
+      ..setFloat32(17, y);
+    return data;
+  }
+}
+
+/// Scroll summed over one capture frame on the controlling machine.
+///
+/// Deltas are fixed-point, in 1/120 of a wheel detent like the kernel's
+/// REL_WHEEL_HI_RES, with positive values scrolling down and right. The
+/// receiver replays each frame over [durationUs] to keep its velocity.
+class ScrollFrame {
+  const ScrollFrame({
+    required this.dx,
+    required this.dy,
+    required this.durationUs,
+  });
+
+  /// Decode a frame, returning `null` for other message types
+  static ScrollFrame? decode(Uint8List data) {
+    if (InputMessageType.of(data) != InputMessageType.scroll ||
+        data.length < encodedSize) {
+      return null;
+    }
+    final view = ByteData.sublistView(data);
+    return ScrollFrame(
+      dx: view.getInt16(1),
+      dy: view.getInt16(3),
+      durationUs: view.getUint16(5),
+    );
+  }
+
+  static const int encodedSize = 7;
+
+  /// Units per wheel detent
+  static const int unitsPerDetent = 120;
+
+  final int dx;
+  final int dy;
+  final int durationUs;
+
+  Uint8List encode() {
+    final data = Uint8List(encodedSize);
+    ByteData.sublistView(data)
+      ..setUint8(0, InputMessageType.scroll.index)
+      ..setInt16(1, dx.clamp(-0x8000, 0x7fff))
+      ..setInt16(3, dy.clamp(-0x8000, 0x7fff))
+      ..setUint16(5, durationUs.clamp(0, 0xffff));
+    return data;
+  }
+}
+
+/// Size of the controlled machine's screen, sent once per connection so the
+/// server can keep the pointer it moves there within bounds.
+class ScreenSizeFrame {
+  const ScreenSizeFrame({required this.width, required this.height});
+
+  /// Decode a frame, returning `null` for other message types
+  static ScreenSizeFrame? decode(Uint8List data) {
+    if (InputMessageType.of(data) != InputMessageType.screenSize ||
+        data.length < encodedSize) {
+      return null;
+    }
+    final view = ByteData.sublistView(data);
+    return ScreenSizeFrame(
+      width: view.getUint16(1),
+      height: view.getUint16(3),
+    );
+  }
+
+  static const int encodedSize = 5;
+
+  final int width;
+  final int height;
+
+  Uint8List encode() {
+    final data = Uint8List(encodedSize);
+    ByteData.sublistView(data)
+      ..setUint8(0, InputMessageType.screenSize.index)
+      ..setUint16(1, width.clamp(0, 0xffff))
+      ..setUint16(3, height.clamp(0, 0xffff));
+    return data;
+  }
+}
+
+/// Whether the receiving machine is the active focus target, sent by the
+/// server whenever focus moves or a client connects.
+class FocusFrame {
+  const FocusFrame({required this.focused});
+
+  /// Decode a frame, returning `null` for other message types
+  static FocusFrame? decode(Uint8List data) {
+    if (InputMessageType.of(data) != InputMessageType.focus ||
+        data.length < encodedSize) {
+      return null;
+    }
+    return FocusFrame(focused: data[1] != 0);
+  }
+
+  static const int encodedSize = 2;
+
+  final bool focused;
+
+  Uint8List encode() {
+    return Uint8List.fromList([InputMessageType.focus.index, focused ? 1 : 0]);
+  }
+}
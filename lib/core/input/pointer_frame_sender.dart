@@ -0,0 +1,67 @@
+import 'dart:async';
+import 'dart:typed_data';
+
+import 'package:desk_switch/core/input/input_message.dart';
+
+/// Server-side producer of [PointerFrame]s for the active client.
+///
+/// Every movement becomes a motion frame. Correction frames with the
+/// authoritative position follow at [correctionInterval] while the pointer
+/// moves and once [settleDelay] after it stops, which is what lets the
+/// client's predictor stop extrapolating without overshooting.
+class PointerFrameSender {
+  PointerFrameSender({
+    required void Function(Uint8List data) send,
+    this.correctionInterval = const Duration(milliseconds: 100),
+    this.settleDelay = const Duration(milliseconds: 40),
+  }) : _send = send;
+
+  final Duration correctionInterval;
+  final Duration settleDelay;
+
+  final void Function(Uint8List data) _send;
+  final Stopwatch _clock = Stopwatch()..start();
+  Timer? _settleTimer;
+  int _sequence = 0;
+  int _lastCorrectionUs = 0;
+  double _x = 0;
+  double _y = 0;
+
+  /// Report the pointer at ([x], [y]) on the controlled screen
+  void move(double x, double y) {
+    _x = x;
+    _y = y;
+    final nowUs = _clock.elapsedMicroseconds;
+    _emit(InputMessageType.pointerMotion, nowUs);
+
+    if (nowUs - _lastCorrectionUs >= correctionInterval.inMicroseconds) {
+      _emit(InputMessageType.pointerCorrection, nowUs);
+    }
+
+    _settleTimer?.cancel();
+    _settleTimer = Timer(settleDelay, () {
+      _settleTimer = null;
+      _emit(InputMessageType.pointerCorrection, _clock.elapsedMicroseconds);
+    });
+  }
+
+  void dispose() {
+    _settleTimer?.cancel();
+    _settleTimer = null;
+  }
+
+  void _emit(InputMessageType type, int nowUs) {
+    if (type == InputMessageType.pointerCorrection) {
+      _lastCorrectionUs = nowUs;
+    }
+    _send(
+      PointerFrame(
+        type: type,
+        sequence: _sequence++,
+        timestampUs: nowUs,
+        x: _x,
+        y: _y,
+      ).encode(),
+    );
+  }
+}
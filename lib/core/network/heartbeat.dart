@@ -0,0 +1,103 @@
+import 'dart:async';
+
+/// Liveness heartbeat for one peer connection that backs off while idle.
+///
+/// While active a ping goes out every [activeInterval]. In idle mode each
+/// ping doubles the interval up to [maxIdleInterval], so a quiet connection
+/// settles at one wakeup per minute or so. Every ping advertises the
+/// sender's next interval, letting the other side time out after
+/// [missedPings] pings fail to arrive regardless of either side's mode.
+class Heartbeat {
+  Heartbeat({
+    required void Function(Duration nextPing) sendPing,
+    required void Function() onTimeout,
+    this.activeInterval = const Duration(seconds: 2),
+    this.maxIdleInterval = const Duration(seconds: 64),
+    this.missedPings = 3,
+  }) : _sendPing = sendPing,
+       _onTimeout = onTimeout,
+       _interval = activeInterval,
+       _peerInterval = activeInterval;
+
+  final Duration activeInterval;
+  final Duration maxIdleInterval;
+  final int missedPings;
+
+  final void Function(Duration nextPing) _sendPing;
+  final void Function() _onTimeout;
+  final Stopwatch _clock = Stopwatch();
+  Timer? _timer;
+  Duration _interval;
+  Duration _peerInterval;
+  int _lastReceivedUs = 0;
+  bool _idle = false;
+
+  /// Interval until the next ping
+  Duration get interval => _interval;
+
+  bool get isRunning => _timer != null;
+
+  void start() {
+    _clock
+      ..reset()
+      ..start();
+    _lastReceivedUs = 0;
+    _schedule();
+  }
+
+  void stop() {
+    _timer?.cancel();
+    _timer = null;
+    _clock.stop();
+  }
+
+  /// Record that something arrived from the peer. Cheap enough to call for
+  /// every frame; it never touches the timer.
+  void notifyReceived() {
+    _lastReceivedUs = _clock.elapsedMicroseconds;
+  }
+
+  /// Record a ping from the peer announcing its next interval
+  void notifyPing(Duration peerInterval) {
+    _peerInterval = peerInterval;
+    notifyReceived();
+  }
+
+  /// Switch between the fast active rate and idle backoff
+  void setIdle(bool idle) {
+    if (_idle == idle) {
+      return;
+    }
+    _idle = idle;
+    if (!idle) {
+      // Back to full rate right away; tell the peer without waiting for
+      // the (possibly minute-long) idle timer
+      _interval = activeInterval;
+      if (isRunning) {
+        _sendPing(_interval);
+        _schedule();
+      }
+    }
+  }
+
+  void _schedule() {
+    _timer?.cancel();
+    _timer = Timer(_interval, _tick);
+  }
+
+  void _tick() {
+    final silentUs = _clock.elapsedMicroseconds - _lastReceivedUs;
+    if (silentUs > _peerInterval.inMicroseconds * missedPings) {
+      stop();
+      _onTimeout();
+      return;
+    }
+
+    if (_idle) {
+      final doubled = _interval * 2;
+      _interval = doubled > maxIdleInterval ? maxIdleInterval : doubled;
+    }
+    _sendPing(_interval);
+    _schedule();
+  }
+}
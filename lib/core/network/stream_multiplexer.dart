@@ -0,0 +1,448 @@
+import 'dart:async';
+import 'dart:collection';
+import 'dart:convert';
+import 'dart:typed_data';
+
+/// Priority classes for multiplexed streams, highest first.
+///
+/// The scheduler always drains a higher class before touching a lower one,
+/// so a keypress never waits behind a clipboard image or a file transfer.
+enum StreamPriority {
+  input,
+  audio,
+  control,
+  clipboard,
+  bulk;
+
+  /// Whether frames of this class are written out inline, without yielding
+  /// to the event loop between chunks.
+  bool get isInline => this == input || this == audio || this == control;
+
+  /// Per-stream flow-control window in bytes.
+  ///
+  /// Kept small for the lower classes so that at most one window of bulk
+  /// data is ever queued in the socket ahead of an input frame.
+  int get initialWindow => switch (this) {
+    input => 64 * 1024,
+    audio => 64 * 1024,
+    control => 256 * 1024,
+    clipboard => 64 * 1024,
+    bulk => 64 * 1024,
+  };
+}
+
+/// Frame types on the wire
+enum MuxFrameType {
+  data,
+  windowUpdate,
+  close,
+  ping,
+}
+
+/// A complete message reassembled from one or more data frames
+class MuxMessage {
+  const MuxMessage({
+    required this.streamId,
+    required this.priority,
+    required this.data,
+  });
+
+  final int streamId;
+  final StreamPriority priority;
+  final Uint8List data;
+
+  /// Decode the payload as UTF-8 text. The bytes come from the peer, so
+  /// malformed sequences become U+FFFD instead of throwing.
+  String get text => utf8.decode(data, allowMalformed: true);
+}
+
+/// Multiplexes prioritized, flow-controlled streams over a single
+/// message-oriented connection (a WebSocket).
+///
+/// Wire format, one frame per WebSocket binary message:
+///
+/// ```text
+/// +------+-------+-----------+----------+---------------------+
+/// | type | flags | stream id | priority | payload             |
+/// | u8   | u8    | u16 (BE)  | u8       | data / u32 BE value |
+/// +------+-------+-----------+----------+---------------------+
+/// ```
+///
+/// Large messages are split into [maxChunkSize] chunks; the last chunk
+/// carries [_flagFin]. Stream ids below [reservedStreamIds] are the default
+/// stream of each [StreamPriority], by index, and exist on both ends
+/// implicitly. Extra streams opened with [openStream] use odd ids on the
+/// initiating side and even ids on the accepting side so the two ends never
+/// collide; the reserved range keeps that true when a class is added.
+///
+/// Ping frames carry the sender's next heartbeat interval in milliseconds
+/// and bypass all queues; they are reported through `onPing` and never
+/// surface as messages.
+///
+/// Credit is granted as data arrives, so it does not bound memory on its
+/// own: a message growing past [maxMessageSize] or a peer opening more than
+/// [maxPeerStreams] streams closes the multiplexer and reports the reason
+/// through `onViolation`, after which the connection should be dropped.
+class StreamMultiplexer {
+  StreamMultiplexer({
+    required void Function(Uint8List frame) send,
+    required bool isInitiator,
+    void Function(Duration nextPing)? onPing,
+    void Function(String reason)? onViolation,
+    this.maxChunkSize = 16 * 1024,
+    this.maxMessageSize = 16 * 1024 * 1024,
+    this.maxPeerStreams = 64,
+  }) : _send = send,
+       _onPing = onPing,
+       _onViolation = onViolation,
+       _nextStreamId = isInitiator
+           ? reservedStreamIds + 1
+           : reservedStreamIds + 2 {
+    assert(StreamPriority.values.length <= reservedStreamIds);
+    for (final priority in StreamPriority.values) {
+      _streams[priority.index] = _MuxStreamState(priority.index, priority);
+    }
+  }
+
+  static const int headerSize = 5;
+
+  /// Ids set aside for the default streams; must stay even
+  static const int reservedStreamIds = 16;
+  static const int _flagFin = 0x01;
+
+  /// Largest payload carried by a single data frame
+  final int maxChunkSize;
+
+  /// Largest message reassembled from the peer
+  final int maxMessageSize;
+
+  /// Most streams the peer may have open beyond the default ones
+  final int maxPeerStreams;
+
+  final void Function(Uint8List frame) _send;
+  final void Function(Duration nextPing)? _onPing;
+  final void Function(String reason)? _onViolation;
+  final Map<int, _MuxStreamState> _streams = {};
+  final Map<StreamPriority, Queue<_MuxStreamState>> _ready = {
+    for (final priority in StreamPriority.values) priority: Queue(),
+  };
+  final StreamController<MuxMessage> _messageController =
+      StreamController<MuxMessage>.broadcast(sync: true);
+
+  int _nextStreamId;
+  int _peerStreamCount = 0;
+  bool _pumpScheduled = false;
+  bool _closed = false;
+
+  /// Reassembled messages from all streams
+  Stream<MuxMessage> get messages => _messageController.stream;
+
+  /// Open an additional stream, e.g. one per file transfer
+  MuxStream openStream(StreamPriority priority) {
+    final id = _nextStreamId;
+    _nextStreamId += 2;
+    _streams[id] = _MuxStreamState(id, priority);
+    return MuxStream._(this, id, priority);
+  }
+
+  /// Send [data] on the default stream of [priority]
+  void send(StreamPriority priority, List<int> data) {
+    _enqueue(_streams[priority.index]!, data);
+  }
+
+  /// Send [message] as UTF-8 on the default stream of [priority]
+  void sendString(StreamPriority priority, String message) {
+    send(priority, utf8.encode(message));
+  }
+
+  /// Send a heartbeat announcing when the next one is due
+  void sendPing(Duration nextPing) {
+    if (_closed) {
+      return;
+    }
+    final frame = Uint8List(headerSize + 4);
+    _writeHeader(
+      frame,
+      MuxFrameType.ping,
+      0,
+      _streams[StreamPriority.control.index]!,
+    );
+    ByteData.sublistView(frame).setUint32(headerSize, nextPing.inMilliseconds);
+    _send(frame);
+  }
+
+  /// Feed a frame received from the underlying connection
+  void handleFrame(List<int> frame) {
+    if (_closed || frame.length < headerSize) {
+      return;
+    }
+
+    final bytes = frame is Uint8List ? frame : Uint8List.fromList(frame);
+    final view = ByteData.sublistView(bytes);
+    final type = MuxFrameType.values.elementAtOrNull(view.getUint8(0));
+    final flags = view.getUint8(1);
+    final streamId = view.getUint16(2);
+    final priority = StreamPriority.values.elementAtOrNull(view.getUint8(4));
+    if (type == null || priority == null) {
+      return;
+    }
+
+    switch (type) {
+      case MuxFrameType.data:
+        var stream = _streams[streamId];
+        if (stream == null) {
+          if (_peerStreamCount >= maxPeerStreams) {
+            _fail('Peer opened more than $maxPeerStreams streams');
+            return;
+          }
+          _peerStreamCount++;
+          stream = _streams[streamId] = _MuxStreamState(
+            streamId,
+            priority,
+            isPeerOpened: true,
+          );
+        }
+        final payload = Uint8List.sublistView(bytes, headerSize);
+        if (stream.incoming.length + payload.length > maxMessageSize) {
+          _fail('Message on stream $streamId exceeds $maxMessageSize bytes');
+          return;
+        }
+        stream.incoming.add(payload);
+        stream.unacknowledged += payload.length;
+
+        // Grant the sender more credit once half the window is used up
+        if (stream.unacknowledged >= priority.initialWindow ~/ 2) {
+          _sendWindowUpdate(stream);
+        }
+
+        if (flags & _flagFin != 0) {
+          _messageController.add(
+            MuxMessage(
+              streamId: streamId,
+              priority: priority,
+              data: stream.incoming.takeBytes(),
+            ),
+          );
+        }
+        break;
+      case MuxFrameType.windowUpdate:
+        final stream = _streams[streamId];
+        if (stream == null || bytes.length < headerSize + 4) {
+          return;
+        }
+        stream.credit += view.getUint32(headerSize);
+        if (stream.hasPending) {
+          _markReady(stream);
+          _pump();
+        }
+        break;
+      case MuxFrameType.close:
+        if (streamId >= reservedStreamIds &&
+            _streams.remove(streamId)?.isPeerOpened == true) {
+          _peerStreamCount--;
+        }
+        break;
+      case MuxFrameType.ping:
+        if (bytes.length >= headerSize + 4) {
+          _onPing?.call(Duration(milliseconds: view.getUint32(headerSize)));
+        }
+        break;
+    }
+  }
+
+  /// Drop all queued data; further sends are ignored
+  Future<void> close() async {
+    _closed = true;
+    for (final queue in _ready.values) {
+      queue.clear();
+    }
+    _streams.clear();
+    await _messageController.close();
+  }
+
+  void _fail(String reason) {
+    close();
+    _onViolation?.call(reason);
+  }
+
+  void _enqueue(_MuxStreamState stream, List<int> data) {
+    if (_closed) {
+      return;
+    }
+    stream.outgoing.add(data is Uint8List ? data : Uint8List.fromList(data));
+    _markReady(stream);
+    _pump();
+  }
+
+  void _markReady(_MuxStreamState stream) {
+    if (!stream.isReady) {
+      stream.isReady = true;
+      _ready[stream.priority]!.add(stream);
+    }
+  }
+
+  /// Write frames in strict priority order.
+  ///
+  /// Inline classes are drained completely. For the lower classes a single
+  /// chunk is written per event-loop turn, which gives newly arrived input a
+  /// chance to jump the queue; streams within a class are served
+  /// round-robin so one large transfer cannot starve another.
+  void _pump() {
+    if (_closed) {
+      return;
+    }
+
+    for (final priority in StreamPriority.values) {
+      final queue = _ready[priority]!;
+      while (queue.isNotEmpty) {
+        final stream = queue.removeFirst();
+        stream.isReady = false;
+
+        if (stream.credit <= 0) {
+          // Parked until the peer sends a window update
+          continue;
+        }
+
+        _writeChunk(stream);
+
+        if (stream.hasPending) {
+          _markReady(stream);
+        } else if (stream.closeRequested) {
+          _writeClose(stream);
+        }
+
+        if (!priority.isInline) {
+          _schedulePump();
+          return;
+        }
+      }
+    }
+  }
+
+  void _schedulePump() {
+    if (_pumpScheduled) {
+      return;
+    }
+    _pumpScheduled = true;
+    Timer.run(() {
+      _pumpScheduled = false;
+      _pump();
+    });
+  }
+
+  void _writeChunk(_MuxStreamState stream) {
+    final message = stream.outgoing.first;
+    final remaining = message.length - stream.offset;
+    final length = [remaining, maxChunkSize, stream.credit].reduce(
+      (a, b) => a < b ? a : b,
+    );
+    final isLast = length == remaining;
+
+    final frame = Uint8List(headerSize + length);
+    _writeHeader(
+      frame,
+      MuxFrameType.data,
+      isLast ? _flagFin : 0,
+      stream,
+    );
+    frame.setRange(
+      headerSize,
+      headerSize + length,
+      message,
+      stream.offset,
+    );
+
+    stream.credit -= length;
+    if (isLast) {
+      stream.outgoing.removeFirst();
+      stream.offset = 0;
+    } else {
+      stream.offset += length;
+    }
+
+    _send(frame);
+  }
+
+  void _writeClose(_MuxStreamState stream) {
+    final frame = Uint8List(headerSize);
+    _writeHeader(frame, MuxFrameType.close, 0, stream);
+    _streams.remove(stream.id);
+    _send(frame);
+  }
+
+  void _sendWindowUpdate(_MuxStreamState stream) {
+    final frame = Uint8List(headerSize + 4);
+    _writeHeader(frame, MuxFrameType.windowUpdate, 0, stream);
+    ByteData.sublistView(frame).setUint32(headerSize, stream.unacknowledged);
+    stream.unacknowledged = 0;
+    _send(frame);
+  }
+
+  void _writeHeader(
+    Uint8List frame,
+    MuxFrameType type,
+    int flags,
+    _MuxStreamState stream,
+  ) {
+    ByteData.sublistView(frame)
+      ..setUint8(0, type.index)
+      ..setUint8(1, flags)
+      ..setUint16(2, stream.id)
+      ..setUint8(4, stream.priority.index);
+  }
+}
+
+/// Handle to a stream opened with [StreamMultiplexer.openStream]
+class MuxStream {
+  MuxStream._(this._mux, this.id, this.priority);
+
+  final StreamMultiplexer _mux;
+  final int id;
+  final StreamPriority priority;
+
+  /// Messages received on this stream
+  Stream<MuxMessage> get messages =>
+      _mux.messages.where((message) => message.streamId == id);
+
+  /// Queue [data] as one message on this stream
+  void send(List<int> data) {
+    final stream = _mux._streams[id];
+    if (stream != null && !stream.closeRequested) {
+      _mux._enqueue(stream, data);
+    }
+  }
+
+  /// Close the stream once all queued data has been written
+  void close() {
+    final stream = _mux._streams[id];
+    if (stream == null || stream.closeRequested) {
+      return;
+    }
+    stream.closeRequested = true;
+    if (!stream.hasPending) {
+      _mux._writeClose(stream);
+    }
+  }
+}
+
+class _MuxStreamState {
+  _MuxStreamState(this.id, this.priority, {this.isPeerOpened = false})
+    : credit = priority.initialWindow;
+
+  final int id;
+  final StreamPriority priority;
+  final bool isPeerOpened;
+
+  // Sending side
+  final Queue<Uint8List> outgoing = Queue();
+  int offset = 0;
+  int credit;
+  bool isReady = false;
+  bool closeRequested = false;
+
+  // Receiving side
+  final BytesBuilder incoming = BytesBuilder(copy: true);
+  int unacknowledged = 0;
+
+  bool get hasPending => outgoing.isNotEmpty;
+}
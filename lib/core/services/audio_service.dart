@@ -0,0 +1,275 @@
+import 'dart:async';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:desk_switch/core/input/input_message.dart';
+import 'package:desk_switch/core/network/stream_multiplexer.dart';
+import 'package:desk_switch/core/services/client_service.dart';
+import 'package:desk_switch/core/services/focus_switch_service.dart';
+import 'package:desk_switch/core/services/server_service.dart';
+import 'package:desk_switch/core/utils/keyed_change_log.dart';
+import 'package:desk_switch/core/utils/logger.dart';
+import 'package:flutter/services.dart';
+import 'package:riverpod_annotation/riverpod_annotation.dart';
+
+part 'audio_service.g.dart';
+
+enum AudioServiceState {
+  unsupported,
+  idle,
+  capturing,
+  playing,
+}
+
+/// Playout statistics reported by the native jitter buffer
+typedef AudioStats = ({
+  int depthMs,
+  int targetMs,
+  double jitterMs,
+  int underruns,
+  int late,
+  int lost,
+});
+
+/// Forwards the controlled machine's audio to the one with the speakers.
+///
+/// The server tells a client with a [FocusFrame] when it becomes or stops
+/// being the active focus target. Only the focused client captures its
+/// default output monitor natively and sends one Opus packet per 10 ms on
+/// the [StreamPriority.audio] stream, each prefixed with a `u32` big-endian
+/// sequence number. The server plays packets from that client alone,
+/// through the runner's adaptive jitter buffer; encoding, decoding and
+/// playout timing never touch the Dart event loop.
+@Riverpod(keepAlive: true)
+class AudioService extends _$AudioService {
+  static const MethodChannel _channel = MethodChannel('desk_switch/audio');
+  static const int _headerSize = 4;
+
+  StreamSubscription? _packetSubscription;
+  StreamSubscription? _clientSubscription;
+  StreamSubscription? _focusSubscription;
+  String? _sourceClientId;
+  bool _focused = false;
+  bool _playbackFailed = false;
+
+  @override
+  AudioServiceState build() {
+    if (!Platform.isLinux) {
+      return AudioServiceState.unsupported;
+    }
+    _channel.setMethodCallHandler(_handleMethodCall);
+
+    ref.listen(clientServiceProvider, (previous, next) {
+      if (next == ClientServiceState.connected) {
+        _followFocusFrames();
+      } else if (previous == ClientServiceState.connected) {
+        _focusSubscription?.cancel();
+        _focusSubscription = null;
+        _setFocused(false);
+      }
+    });
+    ref.listen(serverServiceProvider, (previous, next) {
+      if (next == ServerServiceState.running) {
+        _startPlayback();
+      } else if (previous == ServerServiceState.running) {
+        _stopPlayback();
+      }
+    });
+    ref.listen(focusSwitchServiceProvider, (_, _) => _followFocus());
+
+    ref.onDispose(() {
+      _channel.setMethodCallHandler(null);
+      _packetSubscription?.cancel();
+      _clientSubscription?.cancel();
+      _focusSubscription?.cancel();
+    });
+    return AudioServiceState.idle;
+  }
+
+  /// Current jitter buffer statistics, or `null` when nothing is playing
+  Future<AudioStats?> stats() async {
+    if (state != AudioServiceState.playing) {
+      return null;
+    }
+    final result = await _channel.invokeMapMethod<String, dynamic>(
+      'getStats',
+    );
+    if (result == null) {
+      return null;
+    }
+    return (
+      depthMs: result['depthMs'] as int,
+      targetMs: result['targetMs'] as int,
+      jitterMs: result['jitterMs'] as double,
+      underruns: result['underruns'] as int,
+      late: result['late'] as int,
+      lost: result['lost'] as int,
+    );
+  }
+
+  void _followFocusFrames() {
+    _focusSubscription?.cancel();
+    _focusSubscription = ref
+        .read(clientServiceProvider.notifier)
+        .streamMessages()
+        .where((message) => message.priority == StreamPriority.input)
+        .listen((message) {
+          final frame = FocusFrame.decode(message.data);
+          if (frame != null) {
+            _setFocused(frame.focused);
+          }
+        });
+  }
+
+  void _setFocused(bool focused) {
+    if (focused == _focused) {
+      return;
+    }
+    _focused = focused;
+    if (focused) {
+      _startCapture();
+    } else {
+      _stopCapture();
+    }
+  }
+
+  Future<void> _startCapture() async {
+    try {
+      await _channel.invokeMethod<void>('startCapture');
+      state = AudioServiceState.capturing;
+      logger.info('🔊 Forwarding audio to the server');
+    } on PlatformException catch (error) {
+      logger.error('❌ Failed to capture audio: ${error.message}');
+    }
+  }
+
+  Future<void> _stopCapture() async {
+    await _channel.invokeMethod<void>('stopCapture');
+    if (state == AudioServiceState.capturing) {
+      state = AudioServiceState.idle;
+    }
+  }
+
+  void _startPlayback() {
+    final serverService = ref.read(serverServiceProvider.notifier);
+    _packetSubscription?.cancel();
+    _packetSubscription = serverService
+        .streamMessages()
+        .where((event) => event.message.priority == StreamPriority.audio)
+        .listen((event) => _play(event.clientId, event.message.data));
+    _clientSubscription?.cancel();
+    _clientSubscription = serverService.clientChanges().listen(
+      (change) => _followFocus(
+        connected: switch (change) {
+          KeyedAdded(:final key) || KeyedUpdated(:final key) => key,
+          _ => null,
+        },
+      ),
+    );
+  }
+
+  Future<void> _stopPlayback() async {
+    await _packetSubscription?.cancel();
+    _packetSubscription = null;
+    await _clientSubscription?.cancel();
+    _clientSubscription = null;
+    _sourceClientId = null;
+    _playbackFailed = false;
+    await _channel.invokeMethod<void>('stopPlayback');
+    if (state == AudioServiceState.playing) {
+      state = AudioServiceState.idle;
+    }
+  }
+
+  void _play(String clientId, Uint8List packet) {
+    if (packet.length <= _headerSize) {
+      return;
+    }
+    // Mixing several machines is out of scope: only the focused one plays
+    if (clientId != _sourceClientId || _playbackFailed) {
+      return;
+    }
+    if (state != AudioServiceState.playing) {
+      state = AudioServiceState.playing;
+      logger.info('🔊 Playing audio from $clientId');
+    }
+
+    _channel
+        .invokeMethod<void>('play', {
+          'sequence': ByteData.sublistView(packet).getUint32(0),
+          'data': Uint8List.sublistView(packet, _headerSize),
+        })
+        // Reported once through playbackFailed
+        .onError<PlatformException>((_, _) {});
+  }
+
+  /// Point playback at the focused client. Only the old and the new source
+  /// are told about a change; a [connected] client starts out unfocused, so
+  /// it only needs telling when it is the source.
+  void _followFocus({String? connected}) {
+    if (ref.read(serverServiceProvider) != ServerServiceState.running) {
+      return;
+    }
+    final source = ref
+        .read(serverServiceProvider.notifier)
+        .clientForTarget(ref.read(focusSwitchServiceProvider));
+    if (source == _sourceClientId) {
+      // A resumed session shows up as an update and needs telling again
+      if (source != null && connected == source) {
+        _sendFocus(source, focused: true);
+      }
+      return;
+    }
+
+    final previous = _sourceClientId;
+    _sourceClientId = source;
+    if (previous != null) {
+      _sendFocus(previous, focused: false);
+    }
+    if (source != null) {
+      _sendFocus(source, focused: true);
+    }
+    // Sequence numbers restart with the new source, so does the jitter
+    // buffer; playback that failed gets another try
+    _playbackFailed = false;
+    _channel.invokeMethod<void>('stopPlayback');
+    if (state == AudioServiceState.playing) {
+      state = AudioServiceState.idle;
+    }
+  }
+
+  void _sendFocus(String clientId, {required bool focused}) {
+    ref
+        .read(serverServiceProvider.notifier)
+        .sendData(
+          FocusFrame(focused: focused).encode(),
+          priority: StreamPriority.input,
+          clientId: clientId,
+        );
+  }
+
+  Future<void> _handleMethodCall(MethodCall call) async {
+    switch (call.method) {
+      case 'packet':
+        final args = Map<String, dynamic>.from(call.arguments as Map);
+        final data = args['data'] as Uint8List;
+        final packet = Uint8List(_headerSize + data.length);
+        ByteData.sublistView(packet).setUint32(0, args['sequence'] as int);
+        packet.setRange(_headerSize, packet.length, data);
+        ref
+            .read(clientServiceProvider.notifier)
+            .sendData(packet, priority: StreamPriority.audio);
+        break;
+      case 'playbackFailed':
+        final args = Map<String, dynamic>.from(call.arguments as Map);
+        logger.error('❌ ${args['message']}; audio is off until focus moves');
+        _playbackFailed = true;
+        if (state == AudioServiceState.playing) {
+          state = AudioServiceState.idle;
+        }
+        break;
+      default:
+        throw MissingPluginException('Unknown method ${call.method}');
+    }
+  }
+}
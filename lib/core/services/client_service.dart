@@ -1,9 +1,16 @@
 import 'dart:async';
+import 'dart:convert';
 import 'dart:io';
+import 'dart:math';
 
+import 'package:desk_switch/core/network/heartbeat.dart';
+import 'package:desk_switch/core/network/stream_multiplexer.dart';
+import 'package:desk_switch/core/services/idle_service.dart';
+import 'package:desk_switch/core/services/server_service.dart';
 import 'package:desk_switch/core/utils/logger.dart';
 import 'package:desk_switch/models/server_info.dart';
 import 'package:riverpod_annotation/riverpod_annotation.dart';
+import 'package:uuid/uuid.dart';
 
 part 'client_service.g.dart';
 
@@ -19,11 +26,23 @@ class ClientService extends _$ClientService {
   // WebSocket connection
   WebSocket? _socket;
   StreamController<String>? _messageController;
+  StreamMultiplexer? _multiplexer;
+  Heartbeat? _heartbeat;
   StreamSubscription? _subscription;
   ServerInfo? _connectedServer;
+  String? _sessionId;
+  String? _sessionKey;
+  int _resumeSequence = 0;
+
+  // Bumped by every connect, disconnect and resume, so that only the newest
+  // resumption keeps retrying
+  int _resumeGeneration = 0;
 
   @override
   ClientServiceState build() {
+    ref.listen(idleServiceProvider, (previous, next) {
+      _heartbeat?.setIdle(next == IdleServiceState.idle);
+    });
     return ClientServiceState.disconnected;
   }
 
@@ -32,18 +51,116 @@ class ClientService extends _$ClientService {
     return _messageController?.stream ?? const Stream.empty();
   }
 
+  /// Get the multiplexed stream messages from the server
+  Stream<MuxMessage> streamMessages() {
+    return _multiplexer?.messages ?? const Stream.empty();
+  }
+
+  /// Get the stream multiplexer of the current connection
+  StreamMultiplexer? get multiplexer => _multiplexer;
+
   /// Get the currently connected server
   ServerInfo? get connectedServer => _connectedServer;
 
-  /// Connect to a server using WebSocket
-  Future<void> connect(ServerInfo server) async {
-    disconnect(); // Clean up any previous connection
+  /// Session ID the server knows this connection by
+  String? get sessionId => _sessionId;
+
+  /// Secret that proves this client owns [sessionId] when resuming it
+  String? get sessionKey => _sessionKey;
+
+  /// How many times the current session has been resumed
+  int get resumeSequence => _resumeSequence;
+
+  /// Connect to a server using WebSocket.
+  ///
+  /// Passing the [sessionId] and [sessionKey] of an earlier connection with
+  /// a higher [resumeSequence] resumes that session: the server keeps the
+  /// client's identity and replaces any half-dead socket still holding it.
+  /// Without them a new session with a fresh key is started.
+  Future<void> connect(
+    ServerInfo server, {
+    String? sessionId,
+    String? sessionKey,
+    int resumeSequence = 0,
+  }) {
+    _resumeGeneration++;
+    return _connect(
+      server,
+      sessionId: sessionId,
+      sessionKey: sessionKey,
+      resumeSequence: resumeSequence,
+    );
+  }
+
+  /// Resume [sessionId] on [server], starting at [resumeSequence] and
+  /// retrying with backoff for as long as the server keeps dropped sessions.
+  ///
+  /// Used after a restart and whenever an established connection drops.
+  /// Throws the last error once the server would have forgotten the session.
+  Future<void> resume(
+    ServerInfo server, {
+    required String sessionId,
+    required String sessionKey,
+    required int resumeSequence,
+  }) async {
+    final generation = ++_resumeGeneration;
+    final deadline = DateTime.now().add(ServerService.resumeGracePeriod);
+    for (var attempt = 0; ; attempt++) {
+      try {
+        // Each attempt moves the sequence on, since the server may have
+        // accepted an earlier one before its connection failed
+        await _connect(
+          server,
+          sessionId: sessionId,
+          sessionKey: sessionKey,
+          resumeSequence: resumeSequence + attempt,
+        );
+        return;
+      } catch (_) {
+        if (generation != _resumeGeneration) {
+          return;
+        }
+        if (DateTime.now().isAfter(deadline)) {
+          rethrow;
+        }
+      }
+
+      // Still trying, so stay connecting between attempts
+      state = ClientServiceState.connecting;
+      _connectedServer = server;
+      await Future<void>.delayed(_reconnectDelay(attempt));
+      if (generation != _resumeGeneration) {
+        return;
+      }
+    }
+  }
+
+  Future<void> _connect(
+    ServerInfo server, {
+    String? sessionId,
+    String? sessionKey,
+    required int resumeSequence,
+  }) async {
+    _disconnect(); // Clean up any previous connection
 
     state = ClientServiceState.connecting;
     _connectedServer = server;
+    final isResuming = sessionId != null && sessionKey != null;
+    _sessionId = isResuming ? sessionId : const Uuid().v4();
+    _sessionKey = isResuming ? sessionKey : _newSessionKey();
+    _resumeSequence = resumeSequence;
 
     try {
-      final uri = Uri.parse('ws://${server.host}:${server.port}');
+      final uri = Uri(
+        scheme: 'ws',
+        host: server.host,
+        port: server.port,
+        queryParameters: {
+          'session': _sessionId,
+          'key': _sessionKey,
+          'resume': '$resumeSequence',
+        },
+      );
 
       logger.info(
         '🔌 Connecting to server: ${server.name} at \\${uri.host}:\\${uri.port}',
@@ -51,30 +168,56 @@ class ClientService extends _$ClientService {
 
       _socket = await WebSocket.connect(uri.toString());
       _messageController = StreamController<String>();
+      _multiplexer = StreamMultiplexer(
+        send: _socket!.add,
+        isInitiator: true,
+        onPing: (nextPing) => _heartbeat?.notifyPing(nextPing),
+        onViolation: (reason) {
+          logger.warning('⚠️ Dropping ${server.name}: $reason');
+          disconnect();
+        },
+      );
+      _heartbeat = Heartbeat(
+        sendPing: _multiplexer!.sendPing,
+        onTimeout: () {
+          logger.warning('💔 Heartbeat timed out: ${server.name}');
+          _connectionLost(server);
+        },
+      );
+      final idleService = ref.read(idleServiceProvider.notifier);
+      _multiplexer!.messages.listen((message) {
+        idleService.markActivity();
+        if (message.streamId == StreamPriority.control.index) {
+          _messageController?.add(message.text);
+        }
+      });
 
       // Listen to incoming messages
       _subscription = _socket!.listen(
         (message) {
-          logger.info(message);
+          _heartbeat?.notifyReceived();
           if (message is String) {
+            logger.info(message);
             _messageController?.add(message);
+          } else if (message is List<int>) {
+            _multiplexer?.handleFrame(message);
           }
         },
         onDone: () {
           logger.info('🔌 Disconnected from server: \\${server.name}');
-          state = ClientServiceState.disconnected;
-          _connectedServer = null;
-          _messageController?.close();
+          _connectionLost(server);
         },
         onError: (error) {
           logger.error('❌ Connection error to \\${server.name}: $error');
-          state = ClientServiceState.disconnected;
-          _connectedServer = null;
           _messageController?.addError(error);
+          _connectionLost(server);
         },
         cancelOnError: true,
       );
 
+      _heartbeat!
+        ..setIdle(ref.read(idleServiceProvider) == IdleServiceState.idle)
+        ..start();
       state = ClientServiceState.connected;
       logger.info('✅ Successfully connected to server: \\${server.name}');
     } catch (error) {
@@ -87,7 +230,12 @@ class ClientService extends _$ClientService {
   }
 
   /// Disconnect from the server
-  Future<void> disconnect() async {
+  Future<void> disconnect() {
+    _resumeGeneration++;
+    return _disconnect();
+  }
+
+  Future<void> _disconnect() async {
     if (state == ClientServiceState.disconnecting) {
       logger.info('🔌 Already disconnecting, returning');
       return;
@@ -104,8 +252,12 @@ class ClientService extends _$ClientService {
 
     state = ClientServiceState.disconnecting;
     _connectedServer = null;
+    _heartbeat?.stop();
+    _heartbeat = null;
     await _subscription?.cancel();
     _subscription = null;
+    await _multiplexer?.close();
+    _multiplexer = null;
     await _socket?.close(WebSocketStatus.goingAway);
     _socket = null;
     await _messageController?.close();
@@ -115,8 +267,58 @@ class ClientService extends _$ClientService {
 
   /// Send a message to the server
   void send(String message) {
-    if (state == ClientServiceState.connected && _socket != null) {
-      _socket!.add(message);
+    if (state == ClientServiceState.connected) {
+      _multiplexer?.sendString(StreamPriority.control, message);
+    }
+  }
+
+  /// Send binary data on the default stream of [priority]
+  void sendData(List<int> data, {required StreamPriority priority}) {
+    if (state == ClientServiceState.connected) {
+      _multiplexer?.send(priority, data);
     }
   }
+
+  /// Tear down a connection that dropped on its own and resume its session
+  void _connectionLost(ServerInfo server) {
+    final sessionId = _sessionId!;
+    final sessionKey = _sessionKey!;
+    final rejected = _socket?.closeCode == WebSocketStatus.policyViolation;
+    _heartbeat?.stop();
+    _heartbeat = null;
+    _subscription?.cancel();
+    _subscription = null;
+    _multiplexer?.close();
+    _multiplexer = null;
+    _socket?.close(WebSocketStatus.goingAway);
+    _socket = null;
+    _messageController?.close();
+    _messageController = null;
+
+    if (rejected) {
+      // The server refused this resumption; only the user can start afresh
+      state = ClientServiceState.disconnected;
+      _connectedServer = null;
+      return;
+    }
+    state = ClientServiceState.connecting;
+    unawaited(
+      resume(
+        server,
+        sessionId: sessionId,
+        sessionKey: sessionKey,
+        resumeSequence: _resumeSequence + 1,
+      ).catchError((Object error) {
+        logger.error('❌ Gave up resuming session with ${server.name}: $error');
+      }),
+    );
+  }
+
+  static String _newSessionKey() {
+    final random = Random.secure();
+    return base64Url.encode([for (var i = 0; i < 16; i++) random.nextInt(256)]);
+  }
+
+  static Duration _reconnectDelay(int attempt) =>
+      Duration(milliseconds: 250 << attempt.clamp(0, 5));
 }
@@ -0,0 +1,149 @@
+import 'dart:async';
+import 'dart:ui';
+
+import 'package:desk_switch/core/input/cursor_predictor.dart';
+import 'package:desk_switch/core/input/input_message.dart';
+import 'package:desk_switch/core/network/stream_multiplexer.dart';
+import 'package:desk_switch/core/services/client_service.dart';
+import 'package:desk_switch/core/utils/logger.dart';
+import 'package:riverpod_annotation/riverpod_annotation.dart';
+
+part 'cursor_prediction_service.g.dart';
+
+enum CursorPredictionServiceState {
+  disabled,
+  idle,
+  predicting,
+}
+
+/// Turns pointer frames from the server into positions to inject locally,
+/// optionally running them through a [CursorPredictor].
+///
+/// Positions are rendered at [frameInterval] only while the cursor is moving
+/// or a correction is still blending in; an idle pointer costs no timers.
+@Riverpod(keepAlive: true)
+class CursorPredictionService extends _$CursorPredictionService {
+  static const Duration frameInterval = Duration(milliseconds: 8);
+  static const Duration _statsInterval = Duration(seconds: 1);
+
+  final CursorPredictor _predictor = CursorPredictor();
+  final Stopwatch _clock = Stopwatch()..start();
+  final StreamController<Offset> _positionController =
+      StreamController<Offset>.broadcast();
+  final StreamController<PredictionStats> _statsController =
+      StreamController<PredictionStats>.broadcast();
+  StreamSubscription? _frameSubscription;
+  Timer? _renderTimer;
+  int _lastStatsUs = 0;
+  bool _enabled = true;
+
+  @override
+  CursorPredictionServiceState build() {
+    // The service is usually first read while a connection is already up,
+    // so attach to it right away instead of waiting for a transition
+    ref.listen(
+      clientServiceProvider,
+      (previous, next) {
+        if (next == ClientServiceState.connected) {
+          _attach();
+        } else if (previous == ClientServiceState.connected) {
+          _detach();
+        }
+      },
+      fireImmediately: true,
+    );
+    ref.onDispose(() {
+      _frameSubscription?.cancel();
+      _renderTimer?.cancel();
+    });
+    return CursorPredictionServiceState.idle;
+  }
+
+  /// Positions to inject, in the controlled screen's coordinates
+  Stream<Offset> positions() {
+    return _positionController.stream;
+  }
+
+  /// Periodic snapshots of the prediction error distribution
+  Stream<PredictionStats> stats() {
+    return _statsController.stream;
+  }
+
+  /// Current prediction error distribution
+  PredictionStats get currentStats => _predictor.stats.snapshot();
+
+  bool get isEnabled => _enabled;
+
+  /// Switch prediction on or off; statistics restart either way
+  void setEnabled(bool enabled) {
+    _enabled = enabled;
+    _predictor.reset();
+    _predictor.stats.clear();
+    _stopRendering();
+    state = enabled
+        ? CursorPredictionServiceState.idle
+        : CursorPredictionServiceState.disabled;
+    logger.info('🖱️ Cursor prediction ${enabled ? 'enabled' : 'disabled'}');
+  }
+
+  void _attach() {
+    _frameSubscription?.cancel();
+    _frameSubscription = ref
+        .read(clientServiceProvider.notifier)
+        .streamMessages()
+        .where((message) => message.priority == StreamPriority.input)
+        .listen((message) {
+          final frame = PointerFrame.decode(message.data);
+          if (frame != null) {
+            _handleFrame(frame);
+          }
+        });
+  }
+
+  void _detach() {
+    _frameSubscription?.cancel();
+    _frameSubscription = null;
+    _stopRendering();
+    _predictor.reset();
+  }
+
+  void _handleFrame(PointerFrame frame) {
+    if (!_enabled) {
+      _positionController.add(Offset(frame.x, frame.y));
+      return;
+    }
+
+    final nowUs = _clock.elapsedMicroseconds;
+    _predictor.addFrame(frame, nowUs);
+    _positionController.add(_predictor.predict(nowUs));
+    _startRendering();
+
+    if (nowUs - _lastStatsUs >= _statsInterval.inMicroseconds) {
+      _lastStatsUs = nowUs;
+      _statsController.add(_predictor.stats.snapshot());
+    }
+  }
+
+  void _startRendering() {
+    if (_renderTimer != null) {
+      return;
+    }
+    state = CursorPredictionServiceState.predicting;
+    _renderTimer = Timer.periodic(frameInterval, (_) {
+      final nowUs = _clock.elapsedMicroseconds;
+      if (!_predictor.isSettling(nowUs)) {
+        _stopRendering();
+        return;
+      }
+      _positionController.add(_predictor.predict(nowUs));
+    });
+  }
+
+  void _stopRendering() {
+    _renderTimer?.cancel();
+    _renderTimer = null;
+    if (state == CursorPredictionServiceState.predicting) {
+      state = CursorPredictionServiceState.idle;
+    }
+  }
+}
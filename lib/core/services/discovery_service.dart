@@ -1,6 +1,8 @@
 import 'dart:async';
 
 import 'package:bonsoir/bonsoir.dart';
+import 'package:desk_switch/core/services/idle_service.dart';
+import 'package:desk_switch/core/utils/keyed_change_log.dart';
 import 'package:desk_switch/core/utils/logger.dart';
 import 'package:desk_switch/models/server_info.dart';
 import 'package:riverpod_annotation/riverpod_annotation.dart';
@@ -10,33 +12,69 @@ part 'discovery_service.g.dart';
 enum DiscoveryServiceState {
   idle,
   discovering,
+  paused,
   stopping,
 }
 
 @Riverpod(keepAlive: true)
 class DiscoveryService extends _$DiscoveryService {
   BonsoirDiscovery? _discovery;
-  StreamController<List<ServerInfo>>? _discoveryController;
   StreamSubscription? _discoverySubscription;
-  final Map<String, ServerInfo> _discoveredServers = {};
+  late final KeyedChangeLog<ServerInfo> _discoveredServers = KeyedChangeLog(
+    onCancel: stop,
+  );
 
   @override
   DiscoveryServiceState build() {
+    // Go quiet on the network while nobody uses the machine
+    ref.listen(idleServiceProvider, (previous, next) {
+      if (next == IdleServiceState.idle) {
+        pause();
+      } else {
+        resume();
+      }
+    });
     return DiscoveryServiceState.idle;
   }
 
-  /// Get the discovered servers stream
-  Stream<List<ServerInfo>> discover() async* {
-    if (state == DiscoveryServiceState.discovering) {
-      logger.info('🔍 Discovery already running, returning existing stream');
-      yield* _discoveryController!.stream;
+  /// Get the discovered servers as a snapshot followed by keyed deltas.
+  ///
+  /// Discovery starts with the first subscriber and stops when the last one
+  /// cancels.
+  Stream<KeyedChange<ServerInfo>> discover() async* {
+    if (state == DiscoveryServiceState.discovering ||
+        state == DiscoveryServiceState.paused) {
+      logger.info('🔍 Discovery already running, joining existing log');
+    } else {
+      logger.info('🚀 Starting discovery');
+      await _startBonsoir();
+    }
+    yield* _discoveredServers.changes();
+  }
+
+  /// Stop browsing while keeping the last known servers
+  Future<void> pause() async {
+    if (state != DiscoveryServiceState.discovering) {
+      return;
+    }
+    logger.info('💤 Pausing discovery');
+    state = DiscoveryServiceState.paused;
+    await _discoverySubscription?.cancel();
+    _discoverySubscription = null;
+    await _discovery?.stop();
+    _discovery = null;
+  }
+
+  /// Resume browsing after [pause]; servers found again refresh in place
+  Future<void> resume() async {
+    if (state != DiscoveryServiceState.paused) {
       return;
     }
+    logger.info('⚡ Resuming discovery');
+    await _startBonsoir();
+  }
 
-    logger.info('🚀 Starting discovery');
-    _discoveryController = StreamController<List<ServerInfo>>(
-      onCancel: stop,
-    );
+  Future<void> _startBonsoir() async {
     state = DiscoveryServiceState.discovering;
     _discovery = BonsoirDiscovery(type: '_deskswitch._tcp');
     await _discovery!.ready;
@@ -55,8 +93,7 @@ class DiscoveryService extends _$DiscoveryService {
               name: service.name,
               isOnline: true,
             );
-            _discoveredServers[id] = serverInfo;
-            _discoveryController?.add(_discoveredServers.values.toList());
+            _discoveredServers.put(id, serverInfo);
             // TODO: only resolve when connected?
             service.resolve(_discovery!.serviceResolver);
           }
@@ -65,7 +102,6 @@ class DiscoveryService extends _$DiscoveryService {
           if (service != null) {
             logger.info('❌ Lost server: ${service.name}');
             _discoveredServers.remove(id);
-            _discoveryController?.add(_discoveredServers.values.toList());
           }
           break;
         case BonsoirDiscoveryEventType.discoveryServiceResolved:
@@ -82,8 +118,7 @@ class DiscoveryService extends _$DiscoveryService {
               port: int.tryParse(service.attributes['ws_port'] ?? '0'),
               isOnline: true,
             );
-            _discoveredServers[id] = updatedServer;
-            _discoveryController?.add(_discoveredServers.values.toList());
+            _discoveredServers.put(id, updatedServer);
           }
           break;
         case BonsoirDiscoveryEventType.discoveryStarted:
@@ -106,13 +141,12 @@ class DiscoveryService extends _$DiscoveryService {
     });
 
     await _discovery!.start();
-    _discoveryController?.add([]); // Emit empty list when ready
-    yield* _discoveryController!.stream;
   }
 
   /// Stop discovery
   Future<void> stop() async {
-    if (state == DiscoveryServiceState.stopping) {
+    if (state == DiscoveryServiceState.stopping ||
+        state == DiscoveryServiceState.idle) {
       logger.info('🛑 Discovery already stopping, returning');
       return;
     }
@@ -121,8 +155,6 @@ class DiscoveryService extends _$DiscoveryService {
     state = DiscoveryServiceState.stopping;
     await _discoverySubscription?.cancel();
     _discoverySubscription = null;
-    await _discoveryController?.close();
-    _discoveryController = null;
     await _discovery?.stop();
     _discovery = null;
     _discoveredServers.clear();
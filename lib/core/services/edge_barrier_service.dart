@@ -0,0 +1,101 @@
+import 'dart:io';
+
+import 'package:desk_switch/core/utils/logger.dart';
+import 'package:flutter/services.dart';
+import 'package:riverpod_annotation/riverpod_annotation.dart';
+
+part 'edge_barrier_service.g.dart';
+
+/// Sides of the local screen, in the order used by the native runner
+enum ScreenSide {
+  left,
+  top,
+  right,
+  bottom,
+}
+
+/// Part of a screen side that leads to another machine. [start] and [end]
+/// are fractions of the side's length, [target] is the machine index used
+/// by the focus switcher.
+typedef ScreenEdge = ({ScreenSide side, double start, double end, int target});
+
+enum EdgeBarrierServiceState {
+  unsupported,
+  idle,
+  armed,
+}
+
+/// Bridge to the runner's pointer barriers.
+///
+/// The native side blocks the pointer at each [ScreenEdge] with an XFixes
+/// barrier and switches focus itself once a push clears its hysteresis
+/// threshold, so nothing polls the cursor position.
+@Riverpod(keepAlive: true)
+class EdgeBarrierService extends _$EdgeBarrierService {
+  static const MethodChannel _channel = MethodChannel(
+    'desk_switch/edge_barriers',
+  );
+
+  @override
+  EdgeBarrierServiceState build() {
+    if (!Platform.isLinux) {
+      return EdgeBarrierServiceState.unsupported;
+    }
+    _channel.setMethodCallHandler(_handleMethodCall);
+    ref.onDispose(() => _channel.setMethodCallHandler(null));
+    return EdgeBarrierServiceState.idle;
+  }
+
+  /// Replace all barriers with [edges]
+  Future<void> setEdges(List<ScreenEdge> edges) async {
+    if (state == EdgeBarrierServiceState.unsupported) {
+      return;
+    }
+    if (edges.isEmpty) {
+      return clear();
+    }
+
+    try {
+      final count = await _channel.invokeMethod<int>('setEdges', {
+        'edges': [
+          for (final edge in edges)
+            {
+              'side': edge.side.index,
+              'start': edge.start,
+              'end': edge.end,
+              'target': edge.target,
+            },
+        ],
+      });
+      state = EdgeBarrierServiceState.armed;
+      logger.info('🧱 Armed $count edge barrier(s)');
+    } on PlatformException catch (error) {
+      logger.error('❌ Failed to set edge barriers: ${error.message}');
+      state = EdgeBarrierServiceState.unsupported;
+    }
+  }
+
+  /// Remove all barriers
+  Future<void> clear() async {
+    if (state == EdgeBarrierServiceState.unsupported) {
+      return;
+    }
+    await _channel.invokeMethod<void>('clearEdges');
+    state = EdgeBarrierServiceState.idle;
+  }
+
+  Future<void> _handleMethodCall(MethodCall call) async {
+    switch (call.method) {
+      case 'crossed':
+        final args = Map<String, dynamic>.from(call.arguments as Map);
+        logger.info(
+          '🧱 Crossed ${ScreenSide.values[args['side'] as int].name} edge '
+          'to ${args['target']} at (${args['x']}, ${args['y']}), '
+          '${(args['velocity'] as double).toStringAsFixed(2)} px/ms',
+        );
+        break;
+      default:
+        throw MissingPluginException('Unknown method ${call.method}');
+    }
+  }
+}
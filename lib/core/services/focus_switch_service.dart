@@ -0,0 +1,194 @@
+import 'dart:async';
+import 'dart:io';
+
+import 'package:desk_switch/core/services/idle_service.dart';
+import 'package:desk_switch/core/services/server_service.dart';
+import 'package:desk_switch/core/utils/keyed_change_log.dart';
+import 'package:desk_switch/core/utils/logger.dart';
+import 'package:desk_switch/models/client_info.dart';
+import 'package:flutter/services.dart';
+import 'package:riverpod_annotation/riverpod_annotation.dart';
+
+part 'focus_switch_service.g.dart';
+
+/// Modifier keys for switch hotkeys; the index is the bit sent to native code
+enum HotkeyModifier {
+  shift,
+  control,
+  alt,
+  meta;
+
+  int get bit => 1 << index;
+}
+
+/// Relative hotkey targets understood by the native switcher
+abstract final class HotkeyTarget {
+  static const int local = 0;
+  static const int next = -1;
+  static const int previous = -2;
+}
+
+/// A switch hotkey registered when the service starts
+typedef DefaultHotkey = ({
+  int id,
+  String key,
+  Set<HotkeyModifier> modifiers,
+  int target,
+});
+
+/// Bridge to the runner's native focus switcher.
+///
+/// Hotkeys are grabbed globally and handled natively: the switch happens
+/// in the runner's event loop before Dart hears about it, and this service
+/// only mirrors the result so the UI can update. The state is the index of
+/// the machine that has focus, `0` being this machine. While the server
+/// runs, every connected client is a target after this machine.
+@Riverpod(keepAlive: true)
+class FocusSwitchService extends _$FocusSwitchService {
+  static const MethodChannel _channel = MethodChannel(
+    'desk_switch/focus_switcher',
+  );
+
+  /// Ctrl+Super with the arrows cycles through machines, with Home to come
+  /// back here. Registering one of these ids again replaces its hotkey.
+  static const List<DefaultHotkey> defaultHotkeys = [
+    (
+      id: 0,
+      key: 'Right',
+      modifiers: {HotkeyModifier.control, HotkeyModifier.meta},
+      target: HotkeyTarget.next,
+    ),
+    (
+      id: 1,
+      key: 'Left',
+      modifiers: {HotkeyModifier.control, HotkeyModifier.meta},
+      target: HotkeyTarget.previous,
+    ),
+    (
+      id: 2,
+      key: 'Home',
+      modifiers: {HotkeyModifier.control, HotkeyModifier.meta},
+      target: HotkeyTarget.local,
+    ),
+  ];
+
+  StreamSubscription<KeyedChange<ClientInfo>>? _clientSubscription;
+
+  @override
+  int build() {
+    if (_isSupported) {
+      _channel.setMethodCallHandler(_handleMethodCall);
+      ref.onDispose(() => _channel.setMethodCallHandler(null));
+      Future.microtask(_registerDefaultHotkeys);
+    }
+
+    ref.listen(serverServiceProvider, (previous, next) {
+      if (next == ServerServiceState.running) {
+        final serverService = ref.read(serverServiceProvider.notifier);
+        _clientSubscription?.cancel();
+        _clientSubscription = serverService.clientChanges().listen(
+          (_) => _syncTargets(serverService.clientCount + 1),
+        );
+      } else if (previous == ServerServiceState.running) {
+        _clientSubscription?.cancel();
+        _clientSubscription = null;
+        _syncTargets(1);
+      }
+    });
+    ref.onDispose(() => _clientSubscription?.cancel());
+    return HotkeyTarget.local;
+  }
+
+  bool get _isSupported => Platform.isLinux;
+
+  /// Grab [key] (an X keysym name such as `Right` or `F1`) with
+  /// [modifiers] globally; pressing it switches focus to [target]
+  Future<void> registerHotkey({
+    required int id,
+    required String key,
+    Set<HotkeyModifier> modifiers = const {},
+    int target = HotkeyTarget.next,
+  }) async {
+    if (!_isSupported) {
+      return;
+    }
+    try {
+      await _channel.invokeMethod<void>('registerHotkey', {
+        'id': id,
+        'key': key,
+        'modifiers': modifiers.fold<int>(0, (mask, m) => mask | m.bit),
+        'target': target,
+      });
+      logger.info('⌨️ Registered switch hotkey $id: $modifiers+$key');
+    } on PlatformException catch (error) {
+      logger.error('❌ Failed to register hotkey $key: ${error.message}');
+      rethrow;
+    }
+  }
+
+  /// Release a hotkey registered with [registerHotkey]
+  Future<void> unregisterHotkey(int id) async {
+    if (!_isSupported) {
+      return;
+    }
+    await _channel.invokeMethod<void>('unregisterHotkey', {'id': id});
+  }
+
+  /// Tell the native side how many machines can take focus and which one
+  /// has it now
+  Future<void> setTargets({required int count, int? active}) async {
+    if (active != null) {
+      state = active;
+    }
+    if (!_isSupported) {
+      return;
+    }
+    await _channel.invokeMethod<void>('setTargets', {
+      'count': count,
+      'active': ?active,
+    });
+  }
+
+  /// Focus falls back to this machine when its target is gone
+  Future<void> _syncTargets(int count) async {
+    try {
+      await setTargets(
+        count: count,
+        active: state < count ? null : HotkeyTarget.local,
+      );
+    } on PlatformException catch (error) {
+      logger.error('❌ Failed to update switch targets: ${error.message}');
+    }
+  }
+
+  Future<void> _registerDefaultHotkeys() async {
+    for (final hotkey in defaultHotkeys) {
+      try {
+        await registerHotkey(
+          id: hotkey.id,
+          key: hotkey.key,
+          modifiers: hotkey.modifiers,
+          target: hotkey.target,
+        );
+      } on PlatformException {
+        // Already logged; a key taken by another client stays unavailable
+      }
+    }
+  }
+
+  Future<void> _handleMethodCall(MethodCall call) async {
+    switch (call.method) {
+      case 'switched':
+        ref.read(idleServiceProvider.notifier).markActivity();
+        final args = Map<String, dynamic>.from(call.arguments as Map);
+        final target = args['target'] as int;
+        logger.info(
+          '🔀 Focus switched ${args['previous']} → $target (${args['source']})',
+        );
+        state = target;
+        break;
+      default:
+        throw MissingPluginException('Unknown method ${call.method}');
+    }
+  }
+}
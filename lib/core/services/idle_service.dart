@@ -0,0 +1,88 @@
+import 'dart:async';
+
+import 'package:desk_switch/core/utils/logger.dart';
+import 'package:desk_switch/core/utils/wakeup_meter.dart';
+import 'package:riverpod_annotation/riverpod_annotation.dart';
+
+part 'idle_service.g.dart';
+
+enum IdleServiceState {
+  active,
+  idle,
+}
+
+/// Tracks user and peer activity and switches the app into a low-wakeup
+/// idle mode when nothing happens for [idleTimeout]. Local input reaches it
+/// through the app-wide ActivityListener, and through the pointer and
+/// scroll services while it is captured for a remote machine.
+///
+/// Other services watch this state: heartbeats back off exponentially and
+/// discovery pauses while idle. [markActivity] is on the hot path of every
+/// input event and peer packet, so it only stores a timestamp; the single
+/// idle timer re-arms itself lazily instead of being reset per event.
+@Riverpod(keepAlive: true)
+class IdleService extends _$IdleService {
+  static const Duration idleTimeout = Duration(seconds: 30);
+
+  final Stopwatch _clock = Stopwatch()..start();
+  final WakeupMeter _wakeupMeter = WakeupMeter();
+  Timer? _idleTimer;
+  int _lastActivityUs = 0;
+
+  /// Wakeups per second measured over the last period in each state
+  final Map<IdleServiceState, double> wakeupRates = {};
+
+  @override
+  IdleServiceState build() {
+    _armIdleTimer(idleTimeout);
+    ref.onDispose(() => _idleTimer?.cancel());
+    return IdleServiceState.active;
+  }
+
+  /// Record an input event or peer packet
+  void markActivity() {
+    _lastActivityUs = _clock.elapsedMicroseconds;
+    if (state == IdleServiceState.idle) {
+      _enter(IdleServiceState.active);
+      _armIdleTimer(idleTimeout);
+    }
+  }
+
+  void _armIdleTimer(Duration delay) {
+    _idleTimer?.cancel();
+    _idleTimer = Timer(delay, _checkIdle);
+  }
+
+  void _checkIdle() {
+    final elapsedUs = _clock.elapsedMicroseconds - _lastActivityUs;
+    final remainingUs = idleTimeout.inMicroseconds - elapsedUs;
+    if (remainingUs > 0) {
+      _armIdleTimer(Duration(microseconds: remainingUs));
+      return;
+    }
+    _idleTimer = null;
+    _enter(IdleServiceState.idle);
+  }
+
+  /// Flips the state first so listeners react at once; the wakeup rate of
+  /// the period that ended is measured and logged afterwards
+  void _enter(IdleServiceState next) {
+    final previous = state;
+    state = next;
+    unawaited(_logWakeups(previous, next));
+  }
+
+  Future<void> _logWakeups(
+    IdleServiceState previous,
+    IdleServiceState next,
+  ) async {
+    final rate = await _wakeupMeter.lap();
+    if (rate != null) {
+      wakeupRates[previous] = rate;
+    }
+    logger.info(
+      '${next == IdleServiceState.idle ? '💤' : '⚡'} Entering ${next.name} '
+      'mode (${previous.name}: ${rate?.toStringAsFixed(1) ?? '?'} wakeups/s)',
+    );
+  }
+}
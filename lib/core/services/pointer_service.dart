@@ -0,0 +1,250 @@
+import 'dart:async';
+import 'dart:io';
+import 'dart:typed_data';
+import 'dart:ui';
+
+import 'package:desk_switch/core/input/input_message.dart';
+import 'package:desk_switch/core/input/pointer_frame_sender.dart';
+import 'package:desk_switch/core/network/stream_multiplexer.dart';
+import 'package:desk_switch/core/services/client_service.dart';
+import 'package:desk_switch/core/services/cursor_prediction_service.dart';
+import 'package:desk_switch/core/services/focus_switch_service.dart';
+import 'package:desk_switch/core/services/idle_service.dart';
+import 'package:desk_switch/core/services/server_service.dart';
+import 'package:desk_switch/core/utils/keyed_change_log.dart';
+import 'package:desk_switch/core/utils/logger.dart';
+import 'package:desk_switch/models/client_info.dart';
+import 'package:flutter/services.dart';
+import 'package:riverpod_annotation/riverpod_annotation.dart';
+
+part 'pointer_service.g.dart';
+
+enum PointerServiceState {
+  unsupported,
+  idle,
+  capturing,
+  injecting,
+}
+
+/// Carries the pointer from the controlling machine to the controlled ones.
+///
+/// The running server reads relative motion natively while a remote machine
+/// has focus, and moves that machine's cursor only. It keeps one cursor per
+/// client, clamped to the screen size the client announced with a
+/// [ScreenSizeFrame], and a [PointerFrameSender] turns each cursor's
+/// movement into motion and correction frames. A
+/// connected client announces its screen, lets [CursorPredictionService]
+/// smooth the frames and warps the local pointer to every position it
+/// renders.
+@Riverpod(keepAlive: true)
+class PointerService extends _$PointerService {
+  static const MethodChannel _channel = MethodChannel('desk_switch/pointer');
+
+  final Map<String, _RemoteCursor> _cursors = {};
+  StreamSubscription? _screenSubscription;
+  StreamSubscription? _clientSubscription;
+  StreamSubscription? _positionSubscription;
+  bool _injectionFailed = false;
+
+  @override
+  PointerServiceState build() {
+    if (!Platform.isLinux) {
+      return PointerServiceState.unsupported;
+    }
+    _channel.setMethodCallHandler(_handleMethodCall);
+
+    // A server or connection may already be up when this is first read
+    ref.listen(
+      serverServiceProvider,
+      (previous, next) {
+        if (next == ServerServiceState.running) {
+          _startCapture();
+        } else if (previous == ServerServiceState.running) {
+          _stopCapture();
+        }
+      },
+      fireImmediately: true,
+    );
+    ref.listen(
+      clientServiceProvider,
+      (previous, next) {
+        if (next == ClientServiceState.connected) {
+          _startInjection();
+        } else if (previous == ClientServiceState.connected) {
+          _stopInjection();
+        }
+      },
+      fireImmediately: true,
+    );
+
+    ref.onDispose(() {
+      _channel.setMethodCallHandler(null);
+      _screenSubscription?.cancel();
+      _clientSubscription?.cancel();
+      _positionSubscription?.cancel();
+      _disposeCursors();
+    });
+    return PointerServiceState.idle;
+  }
+
+  Future<void> _startCapture() async {
+    final serverService = ref.read(serverServiceProvider.notifier);
+    _screenSubscription?.cancel();
+    _screenSubscription = serverService
+        .streamMessages()
+        .where((event) => event.message.priority == StreamPriority.input)
+        .listen((event) {
+          final frame = ScreenSizeFrame.decode(event.message.data);
+          if (frame != null) {
+            _cursorFor(event.clientId).resize(frame.width, frame.height);
+          }
+        });
+    _clientSubscription?.cancel();
+    _clientSubscription = serverService.clientChanges().listen((change) {
+      if (change is KeyedRemoved<ClientInfo>) {
+        _cursors.remove(change.key)?.dispose();
+      }
+    });
+
+    try {
+      await _channel.invokeMethod<void>('startCapture');
+      state = PointerServiceState.capturing;
+      logger.info('🖱️ Capturing pointer motion');
+    } on PlatformException catch (error) {
+      logger.error('❌ Failed to capture the pointer: ${error.message}');
+    }
+  }
+
+  Future<void> _stopCapture() async {
+    await _screenSubscription?.cancel();
+    _screenSubscription = null;
+    await _clientSubscription?.cancel();
+    _clientSubscription = null;
+    _disposeCursors();
+    await _channel.invokeMethod<void>('stopCapture');
+    if (state == PointerServiceState.capturing) {
+      state = PointerServiceState.idle;
+    }
+  }
+
+  _RemoteCursor _cursorFor(String clientId) {
+    return _cursors.putIfAbsent(
+      clientId,
+      () => _RemoteCursor(
+        (data) => ref
+            .read(serverServiceProvider.notifier)
+            .sendData(
+              data,
+              priority: StreamPriority.input,
+              clientId: clientId,
+            ),
+      ),
+    );
+  }
+
+  void _disposeCursors() {
+    for (final cursor in _cursors.values) {
+      cursor.dispose();
+    }
+    _cursors.clear();
+  }
+
+  Future<void> _startInjection() async {
+    try {
+      final size = await _channel.invokeMapMethod<String, int>(
+        'getScreenSize',
+      );
+      ref
+          .read(clientServiceProvider.notifier)
+          .sendData(
+            ScreenSizeFrame(
+              width: size!['width']!,
+              height: size['height']!,
+            ).encode(),
+            priority: StreamPriority.input,
+          );
+    } on PlatformException catch (error) {
+      logger.error('❌ Failed to read the screen size: ${error.message}');
+      return;
+    }
+
+    _positionSubscription?.cancel();
+    _positionSubscription = ref
+        .read(cursorPredictionServiceProvider.notifier)
+        .positions()
+        .listen(_warp);
+  }
+
+  Future<void> _stopInjection() async {
+    await _positionSubscription?.cancel();
+    _positionSubscription = null;
+    if (state == PointerServiceState.injecting) {
+      state = PointerServiceState.idle;
+    }
+  }
+
+  Future<void> _warp(Offset position) async {
+    if (_injectionFailed) {
+      return;
+    }
+    try {
+      await _channel.invokeMethod<void>('warp', {
+        'x': position.dx,
+        'y': position.dy,
+      });
+      state = PointerServiceState.injecting;
+    } on PlatformException catch (error) {
+      // Without XTest every position would fail the same way
+      _injectionFailed = true;
+      logger.error('❌ Failed to move the pointer: ${error.message}');
+    }
+  }
+
+  Future<void> _handleMethodCall(MethodCall call) async {
+    switch (call.method) {
+      case 'motion':
+        ref.read(idleServiceProvider.notifier).markActivity();
+        final args = Map<String, dynamic>.from(call.arguments as Map);
+        final dx = args['dx'] as double;
+        final dy = args['dy'] as double;
+        // Only the focused machine's cursor moves; one that has not
+        // announced its screen yet has nothing to clamp to
+        final clientId = ref
+            .read(serverServiceProvider.notifier)
+            .clientForTarget(ref.read(focusSwitchServiceProvider));
+        _cursors[clientId]?.move(dx, dy);
+        break;
+      default:
+        throw MissingPluginException('Unknown method ${call.method}');
+    }
+  }
+}
+
+/// The pointer of one controlled machine, as moved by the server
+class _RemoteCursor {
+  _RemoteCursor(void Function(Uint8List data) send)
+    : _sender = PointerFrameSender(send: send);
+
+  final PointerFrameSender _sender;
+  Size _screen = Size.zero;
+  Offset _position = Offset.zero;
+
+  /// Set the screen bounds and start from their centre
+  void resize(int width, int height) {
+    _screen = Size(width.toDouble(), height.toDouble());
+    _position = _screen.center(Offset.zero);
+  }
+
+  void move(double dx, double dy) {
+    if (_screen.isEmpty) {
+      return;
+    }
+    _position = Offset(
+      (_position.dx + dx).clamp(0, _screen.width - 1),
+      (_position.dy + dy).clamp(0, _screen.height - 1),
+    );
+    _sender.move(_position.dx, _position.dy);
+  }
+
+  void dispose() => _sender.dispose();
+}
@@ -0,0 +1,160 @@
+import 'dart:async';
+import 'dart:io';
+
+import 'package:desk_switch/core/input/input_message.dart';
+import 'package:desk_switch/core/network/stream_multiplexer.dart';
+import 'package:desk_switch/core/services/client_service.dart';
+import 'package:desk_switch/core/services/focus_switch_service.dart';
+import 'package:desk_switch/core/services/idle_service.dart';
+import 'package:desk_switch/core/services/server_service.dart';
+import 'package:desk_switch/core/utils/logger.dart';
+import 'package:flutter/services.dart';
+import 'package:riverpod_annotation/riverpod_annotation.dart';
+
+part 'scroll_service.g.dart';
+
+enum ScrollServiceState {
+  unsupported,
+  idle,
+  capturing,
+  injecting,
+}
+
+/// Forwards touchpad and hi-res wheel scrolling without losing precision.
+///
+/// The running server captures smooth-scroll valuators natively and gets
+/// one [ScrollFrame] per 8 ms frame while a remote machine has focus; it
+/// sends each to that machine alone on the [StreamPriority.input] stream. A
+/// connected client hands the frames back to the runner, which replays them
+/// through a virtual wheel over their original duration, so sub-detent
+/// deltas and scroll velocity both survive the trip.
+@Riverpod(keepAlive: true)
+class ScrollService extends _$ScrollService {
+  static const MethodChannel _channel = MethodChannel('desk_switch/scroll');
+
+  StreamSubscription? _frameSubscription;
+  bool _injectionFailed = false;
+
+  @override
+  ScrollServiceState build() {
+    if (!Platform.isLinux) {
+      return ScrollServiceState.unsupported;
+    }
+    _channel.setMethodCallHandler(_handleMethodCall);
+
+    // A server or connection may already be up when this is first read
+    ref.listen(
+      serverServiceProvider,
+      (previous, next) {
+        if (next == ServerServiceState.running) {
+          _startCapture();
+        } else if (previous == ServerServiceState.running) {
+          _stopCapture();
+        }
+      },
+      fireImmediately: true,
+    );
+    ref.listen(
+      clientServiceProvider,
+      (previous, next) {
+        if (next == ClientServiceState.connected) {
+          _startInjection();
+        } else if (previous == ClientServiceState.connected) {
+          _stopInjection();
+        }
+      },
+      fireImmediately: true,
+    );
+
+    ref.onDispose(() {
+      _channel.setMethodCallHandler(null);
+      _frameSubscription?.cancel();
+    });
+    return ScrollServiceState.idle;
+  }
+
+  Future<void> _startCapture() async {
+    try {
+      final axes = await _channel.invokeMethod<int>('startCapture');
+      state = ScrollServiceState.capturing;
+      logger.info('🖱️ Capturing smooth scroll from $axes axes');
+    } on PlatformException catch (error) {
+      logger.error('❌ Failed to capture scrolling: ${error.message}');
+    }
+  }
+
+  Future<void> _stopCapture() async {
+    await _channel.invokeMethod<void>('stopCapture');
+    if (state == ScrollServiceState.capturing) {
+      state = ScrollServiceState.idle;
+    }
+  }
+
+  void _startInjection() {
+    _frameSubscription?.cancel();
+    _frameSubscription = ref
+        .read(clientServiceProvider.notifier)
+        .streamMessages()
+        .where((message) => message.priority == StreamPriority.input)
+        .listen((message) {
+          final frame = ScrollFrame.decode(message.data);
+          if (frame != null) {
+            _inject(frame);
+          }
+        });
+  }
+
+  Future<void> _stopInjection() async {
+    await _frameSubscription?.cancel();
+    _frameSubscription = null;
+    await _channel.invokeMethod<void>('stopInjection');
+    if (state == ScrollServiceState.injecting) {
+      state = ScrollServiceState.idle;
+    }
+  }
+
+  Future<void> _inject(ScrollFrame frame) async {
+    if (_injectionFailed) {
+      return;
+    }
+    try {
+      await _channel.invokeMethod<void>('inject', {
+        'dx': frame.dx,
+        'dy': frame.dy,
+        'durationUs': frame.durationUs,
+      });
+      state = ScrollServiceState.injecting;
+    } on PlatformException catch (error) {
+      // Without access to /dev/uinput every frame would fail the same way
+      _injectionFailed = true;
+      logger.error('❌ Failed to inject scrolling: ${error.message}');
+    }
+  }
+
+  Future<void> _handleMethodCall(MethodCall call) async {
+    switch (call.method) {
+      case 'scroll':
+        ref.read(idleServiceProvider.notifier).markActivity();
+        final args = Map<String, dynamic>.from(call.arguments as Map);
+        final frame = ScrollFrame(
+          dx: args['dx'] as int,
+          dy: args['dy'] as int,
+          durationUs: args['durationUs'] as int,
+        );
+        final serverService = ref.read(serverServiceProvider.notifier);
+        final clientId = serverService.clientForTarget(
+          ref.read(focusSwitchServiceProvider),
+        );
+        if (clientId != null) {
+          serverService.sendData(
+            frame.encode(),
+            priority: StreamPriority.input,
+            clientId: clientId,
+          );
+        }
+        break;
+      default:
+        throw MissingPluginException('Unknown method ${call.method}');
+    }
+  }
+}
@@ -1,7 +1,12 @@
 import 'dart:async';
+import 'dart:convert';
 import 'dart:io';
 
+import 'package:desk_switch/core/network/heartbeat.dart';
+import 'package:desk_switch/core/network/stream_multiplexer.dart';
+import 'package:desk_switch/core/services/idle_service.dart';
 import 'package:desk_switch/core/services/system_service.dart';
+import 'package:desk_switch/core/utils/keyed_change_log.dart';
 import 'package:desk_switch/core/utils/logger.dart';
 import 'package:desk_switch/models/client_info.dart';
 import 'package:desk_switch/models/server_info.dart';
@@ -10,6 +15,9 @@ import 'package:uuid/uuid.dart';
 
 part 'server_service.g.dart';
 
+/// What the server needs to accept the resumption of a session
+typedef ResumableSession = ({int resumeSequence, String key});
+
 enum ServerServiceState {
   stopped,
   starting,
@@ -19,17 +27,31 @@ enum ServerServiceState {
 
 @Riverpod(keepAlive: true)
 class ServerService extends _$ServerService {
+  /// How long a dropped session can still be resumed
+  static const Duration resumeGracePeriod = Duration(minutes: 2);
+
   // WebSocket Server
   HttpServer? _wsServer;
   ServerInfo? _serverInfo;
-  final Map<String, ClientInfo> _clients = {};
+  final KeyedChangeLog<ClientInfo> _clients = KeyedChangeLog();
+  final Map<String, StreamMultiplexer> _multiplexers = {};
+  final Map<String, Heartbeat> _heartbeats = {};
+  final Map<String, int> _resumeSequences = {};
+  final Map<String, String> _sessionKeys = {};
+  final Map<String, Timer> _resumeExpiry = {};
   final StreamController<String> _messageController =
       StreamController<String>.broadcast();
-  final StreamController<List<ClientInfo>> _clientsController =
-      StreamController<List<ClientInfo>>.broadcast();
+  final StreamController<({String clientId, MuxMessage message})>
+  _streamMessageController =
+      StreamController<({String clientId, MuxMessage message})>.broadcast();
 
   @override
   ServerServiceState build() {
+    ref.listen(idleServiceProvider, (previous, next) {
+      for (final heartbeat in _heartbeats.values) {
+        heartbeat.setIdle(next == IdleServiceState.idle);
+      }
+    });
     return ServerServiceState.stopped;
   }
 
@@ -38,16 +60,51 @@ class ServerService extends _$ServerService {
     return _messageController.stream;
   }
 
-  /// Get the connected clients stream
-  Stream<List<ClientInfo>> clients() {
-    return _clientsController.stream;
+  /// Get the multiplexed stream messages from all clients
+  Stream<({String clientId, MuxMessage message})> streamMessages() {
+    return _streamMessageController.stream;
   }
 
+  /// Get the connected clients as a snapshot followed by keyed deltas
+  Stream<KeyedChange<ClientInfo>> clientChanges() {
+    return _clients.changes();
+  }
+
+  /// Get the running server's info
+  ServerInfo? get serverInfo => _serverInfo;
+
   /// Get the current clients
   List<ClientInfo> get currentClients => _clients.values.toList();
 
-  /// Start WebSocket server
-  Future<ServerInfo?> start() async {
+  /// Number of connected clients
+  int get clientCount => _clients.length;
+
+  /// The client behind focus target [target]. Target `0` is this machine;
+  /// remote targets follow the order the clients connected in.
+  String? clientForTarget(int target) =>
+      target <= 0 ? null : _clients.keys.elementAtOrNull(target - 1);
+
+  /// How many times the session of [clientId] has been resumed
+  int resumeSequence(String clientId) => _resumeSequences[clientId] ?? 0;
+
+  /// The secret the client of [clientId] must present to resume its session
+  String? sessionKey(String clientId) => _sessionKeys[clientId];
+
+  /// Accept resumptions of sessions recorded before a restart for the next
+  /// [resumeGracePeriod]
+  void adoptSessions(Map<String, ResumableSession> sessions) {
+    for (final MapEntry(key: id, value: session) in sessions.entries) {
+      if (!_sessionKeys.containsKey(id) && session.key.isNotEmpty) {
+        _resumeSequences[id] = session.resumeSequence;
+        _sessionKeys[id] = session.key;
+        _expireSession(id);
+      }
+    }
+  }
+
+  /// Start WebSocket server, on [port] if it is free so that clients of a
+  /// previous run can reconnect
+  Future<ServerInfo?> start({int? port}) async {
     if (state == ServerServiceState.running) {
       logger.info('🖥️ Server already running');
       return _serverInfo;
@@ -57,10 +114,7 @@ class ServerService extends _$ServerService {
 
     try {
       // Start WebSocket server
-      _wsServer = await HttpServer.bind(
-        InternetAddress.anyIPv4,
-        0, // TODO: get port from config
-      );
+      _wsServer = await _bind(port);
       _wsServer!.listen((HttpRequest request) async {
         if (WebSocketTransformer.isUpgradeRequest(request)) {
           final ws = await WebSocketTransformer.upgrade(request);
@@ -70,16 +124,58 @@ class ServerService extends _$ServerService {
               request.connectionInfo?.remoteAddress.address ?? 'unknown';
           final clientPort = request.connectionInfo?.remotePort ?? 0;
 
+          final sessionId = _acceptSession(request.uri.queryParameters);
+          if (sessionId == null) {
+            await ws.close(WebSocketStatus.policyViolation, 'Stale session');
+            return;
+          }
+
           final clientInfo = ClientInfo(
-            id: const Uuid().v4(),
+            id: sessionId,
             name: clientAddress,
             port: clientPort,
             socket: ws,
             isActive: true,
           );
 
-          _clients[clientInfo.id] = clientInfo;
-          _notifyClientsChanged();
+          late final Heartbeat heartbeat;
+          final multiplexer = StreamMultiplexer(
+            send: ws.add,
+            isInitiator: false,
+            onPing: (nextPing) => heartbeat.notifyPing(nextPing),
+            onViolation: (reason) {
+              logger.warning('⚠️ Dropping ${clientInfo.name}: $reason');
+              ws.close(WebSocketStatus.policyViolation, reason);
+              _removeClient(clientInfo.id, ws);
+            },
+          );
+          heartbeat = Heartbeat(
+            sendPing: multiplexer.sendPing,
+            onTimeout: () {
+              logger.warning('💔 Heartbeat timed out: ${clientInfo.name}');
+              ws.close(WebSocketStatus.goingAway);
+              _removeClient(clientInfo.id, ws);
+            },
+          )..setIdle(ref.read(idleServiceProvider) == IdleServiceState.idle);
+          final idleService = ref.read(idleServiceProvider.notifier);
+          multiplexer.messages.listen((message) {
+            // Audio streams in whether or not anyone is at the keyboard
+            if (message.priority != StreamPriority.audio) {
+              idleService.markActivity();
+            }
+            _streamMessageController.add(
+              (clientId: clientInfo.id, message: message),
+            );
+            if (message.streamId == StreamPriority.control.index) {
+              _messageController.add(message.text);
+            }
+          });
+
+          // A resumed session replaces whatever is left of its old socket
+          _closeSession(clientInfo.id);
+          _multiplexers[clientInfo.id] = multiplexer;
+          _heartbeats[clientInfo.id] = heartbeat..start();
+          _clients.put(clientInfo.id, clientInfo);
 
           logger.info(
             '🔌 Client connected: ${clientInfo.name} ([32m${_clients.length}[0m total)',
@@ -87,20 +183,22 @@ class ServerService extends _$ServerService {
 
           ws.listen(
             (data) {
-              logger.info(data);
+              heartbeat.notifyReceived();
               if (data is String) {
+                logger.info(data);
                 _messageController.add(data);
+              } else if (data is List<int>) {
+                multiplexer.handleFrame(data);
               }
-              // Optionally handle binary data
             },
             onDone: () {
-              _removeClient(clientInfo.id);
+              _removeClient(clientInfo.id, ws);
             },
             onError: (error) {
               logger.error(
                 '❌ WebSocket error from ${clientInfo.name}: $error',
               );
-              _removeClient(clientInfo.id);
+              _removeClient(clientInfo.id, ws);
             },
             cancelOnError: true,
           );
@@ -130,7 +228,6 @@ class ServerService extends _$ServerService {
       rethrow;
     }
 
-    _notifyClientsChanged();
     return _serverInfo;
   }
 
@@ -149,8 +246,21 @@ class ServerService extends _$ServerService {
       _serverInfo = null;
 
       // Close all client connections
+      for (final multiplexer in _multiplexers.values) {
+        await multiplexer.close();
+      }
+      _multiplexers.clear();
+      for (final heartbeat in _heartbeats.values) {
+        heartbeat.stop();
+      }
+      _heartbeats.clear();
+      for (final timer in _resumeExpiry.values) {
+        timer.cancel();
+      }
+      _resumeExpiry.clear();
+      _resumeSequences.clear();
+      _sessionKeys.clear();
       _clients.clear();
-      _notifyClientsChanged();
 
       state = ServerServiceState.stopped;
       logger.info('🛑 Server stopped');
@@ -163,26 +273,112 @@ class ServerService extends _$ServerService {
 
   /// Send a message to all connected clients or a specific client
   void send(String message, [String? clientId]) {
-    for (final client in _clients.values) {
-      if (clientId == null || client.id == clientId) {
-        client.socket?.add(message);
+    sendData(
+      utf8.encode(message),
+      priority: StreamPriority.control,
+      clientId: clientId,
+    );
+  }
+
+  /// Send binary data on the default stream of [priority] to all connected
+  /// clients or a specific client
+  void sendData(
+    List<int> data, {
+    required StreamPriority priority,
+    String? clientId,
+  }) {
+    if (clientId != null) {
+      _multiplexers[clientId]?.send(priority, data);
+      return;
+    }
+    for (final multiplexer in _multiplexers.values) {
+      multiplexer.send(priority, data);
+    }
+  }
+
+  /// Get the stream multiplexer of a connected client
+  StreamMultiplexer? multiplexer(String clientId) => _multiplexers[clientId];
+
+  Future<HttpServer> _bind(int? port) async {
+    if (port != null && port != 0) {
+      try {
+        return await HttpServer.bind(InternetAddress.anyIPv4, port);
+      } on SocketException catch (error) {
+        logger.warning('⚠️ Port $port unavailable, picking another: $error');
       }
     }
+    return HttpServer.bind(
+      InternetAddress.anyIPv4,
+      0, // TODO: get port from config
+    );
   }
 
-  /// Remove a client from the connected clients list
-  void _removeClient(String clientId) {
+  /// Pick the client ID for a new connection.
+  ///
+  /// A client names its session and a secret key on its first connection.
+  /// Resuming that session later takes the same key and a resume sequence
+  /// that moves forward, so knowing another client's ID is not enough to
+  /// take over its identity. A client that sends no key gets a fresh ID.
+  /// Returns `null` for a rejected resumption.
+  String? _acceptSession(Map<String, String> parameters) {
+    final sessionId = parameters['session'];
+    final key = parameters['key'] ?? '';
+    if (sessionId == null || sessionId.isEmpty || key.isEmpty) {
+      return const Uuid().v4();
+    }
+    final resume = int.tryParse(parameters['resume'] ?? '') ?? 0;
+    final knownKey = _sessionKeys[sessionId];
+    if (knownKey == null) {
+      _sessionKeys[sessionId] = key;
+      _resumeSequences[sessionId] = resume;
+      return sessionId;
+    }
+    if (key != knownKey) {
+      logger.warning('⚠️ Rejected session $sessionId: wrong key');
+      return null;
+    }
+    if (resume <= (_resumeSequences[sessionId] ?? -1)) {
+      logger.warning('⚠️ Rejected stale resumption of session $sessionId');
+      return null;
+    }
+    logger.info('♻️ Resuming session $sessionId (#$resume)');
+    _resumeExpiry.remove(sessionId)?.cancel();
+    _resumeSequences[sessionId] = resume;
+    return sessionId;
+  }
+
+  void _closeSession(String clientId) {
+    _multiplexers.remove(clientId)?.close();
+    _heartbeats.remove(clientId)?.stop();
+    _clients[clientId]?.socket?.close(WebSocketStatus.goingAway);
+  }
+
+  /// Remove a client from the connected clients list, unless its session
+  /// has already moved on to a newer [socket]
+  void _removeClient(String clientId, WebSocket socket) {
+    if (!identical(_clients[clientId]?.socket, socket)) {
+      return;
+    }
     final info = _clients.remove(clientId);
-    _notifyClientsChanged();
+    if (info == null) {
+      return;
+    }
+    _multiplexers.remove(clientId)?.close();
+    _heartbeats.remove(clientId)?.stop();
+    _expireSession(clientId);
     logger.info(
-      '🔌 Client disconnected: ${info?.name} ([31m${_clients.length}[0m remaining)',
+      '🔌 Client disconnected: ${info.name} ([31m${_clients.length}[0m remaining)',
     );
   }
 
-  /// Notify listeners that the clients list has changed
-  void _notifyClientsChanged() {
-    if (!_clientsController.isClosed) {
-      _clientsController.add(_clients.values.toList());
-    }
+  /// Forget the resume sequence of [clientId] unless its session comes
+  /// back within [resumeGracePeriod]
+  void _expireSession(String clientId) {
+    _resumeExpiry[clientId]?.cancel();
+    _resumeExpiry[clientId] = Timer(resumeGracePeriod, () {
+      _resumeExpiry.remove(clientId);
+      _resumeSequences.remove(clientId);
+      _sessionKeys.remove(clientId);
+    });
   }
 }
@@ -0,0 +1,322 @@
+import 'dart:async';
+import 'dart:io';
+
+import 'package:desk_switch/core/services/broadcast_service.dart';
+import 'package:desk_switch/core/services/client_service.dart';
+import 'package:desk_switch/core/services/focus_switch_service.dart';
+import 'package:desk_switch/core/services/server_service.dart';
+import 'package:desk_switch/core/utils/keyed_change_log.dart';
+import 'package:desk_switch/core/utils/logger.dart';
+import 'package:desk_switch/models/client_info.dart';
+import 'package:desk_switch/models/server_info.dart';
+import 'package:flutter/services.dart';
+import 'package:riverpod_annotation/riverpod_annotation.dart';
+
+part 'session_service.g.dart';
+
+/// Which side of a connection this machine was on, in native order
+enum SessionRole {
+  none,
+  server,
+  client,
+}
+
+/// A peer recorded in the session snapshot
+typedef SessionPeer = ({
+  String peerId,
+  String sessionId,
+  String sessionKey,
+  String name,
+  String? host,
+  int? port,
+  int resumeSequence,
+});
+
+enum SessionServiceState {
+  unsupported,
+  restoring,
+  recording,
+}
+
+/// Keeps the runner's crash-safe session snapshot up to date and
+/// re-adopts the sessions it holds after a restart.
+///
+/// The snapshot lives in a memory-mapped file owned by the native runner,
+/// which discards it when the user quits. After a crash or a restart, e.g.
+/// by an updater, the runner has already restored the active target by the
+/// time Dart starts. This service then restarts the server on its old port, or
+/// reconnects to the old server with the same session ID, so peers see a
+/// resumption instead of a new machine.
+@Riverpod(keepAlive: true)
+class SessionService extends _$SessionService {
+  static const MethodChannel _channel = MethodChannel('desk_switch/session');
+
+  final KeyedView<ClientInfo> _clients = KeyedView();
+  StreamSubscription? _clientSubscription;
+
+  // Restored peers that have not reconnected yet, by session ID
+  final Map<String, SessionPeer> _restoredPeers = {};
+  Timer? _restoredPeersExpiry;
+  bool _writeScheduled = false;
+
+  @override
+  SessionServiceState build() {
+    if (!Platform.isLinux) {
+      return SessionServiceState.unsupported;
+    }
+
+    ref.listen(serverServiceProvider, (previous, next) {
+      if (next == ServerServiceState.running) {
+        _clientSubscription?.cancel();
+        _clientSubscription = ref
+            .read(serverServiceProvider.notifier)
+            .clientChanges()
+            .listen((change) {
+              if (_clients.apply(change)) {
+                _scheduleWrite();
+              }
+            });
+      } else if (previous == ServerServiceState.running) {
+        _clientSubscription?.cancel();
+        _clientSubscription = null;
+        _clients.clear();
+        _forgetRestoredPeers();
+      }
+      _scheduleWrite();
+    });
+    ref.listen(clientServiceProvider, (_, _) => _scheduleWrite());
+    ref.listen(focusSwitchServiceProvider, (_, _) => _scheduleWrite());
+    ref.onDispose(() {
+      _clientSubscription?.cancel();
+      _restoredPeersExpiry?.cancel();
+    });
+
+    // Nothing is written until the old snapshot has been read back
+    Future.microtask(_restore);
+    return SessionServiceState.restoring;
+  }
+
+  Future<void> _restore() async {
+    final clock = Stopwatch()..start();
+    try {
+      final snapshot = await _channel.invokeMapMethod<String, dynamic>(
+        'restore',
+      );
+      if (snapshot != null) {
+        await _adopt(snapshot, clock);
+      }
+    } on PlatformException catch (error) {
+      logger.error('❌ Failed to restore session: ${error.message}');
+    } catch (error) {
+      logger.error('❌ Failed to resume session: $error');
+    }
+    state = SessionServiceState.recording;
+    _scheduleWrite();
+  }
+
+  Future<void> _adopt(Map<String, dynamic> snapshot, Stopwatch clock) async {
+    // The runner only hands over recent snapshots from this boot; quitting
+    // discards them
+    final savedAt = DateTime.fromMicrosecondsSinceEpoch(
+      snapshot['savedAtUs'] as int,
+    );
+    logger.info(
+      '🗃️ Found session snapshot from '
+      '${DateTime.now().difference(savedAt).inSeconds}s ago',
+    );
+
+    final role =
+        SessionRole.values.elementAtOrNull(snapshot['role'] as int) ??
+        SessionRole.none;
+    final peers = [
+      for (final entry in snapshot['peers'] as List)
+        _decodePeer(Map<String, dynamic>.from(entry as Map)),
+    ];
+
+    final targetCount = snapshot['targetCount'] as int;
+    if (targetCount > 1) {
+      await ref
+          .read(focusSwitchServiceProvider.notifier)
+          .setTargets(
+            count: targetCount,
+            active: snapshot['activeTarget'] as int,
+          );
+    }
+
+    switch (role) {
+      case SessionRole.server:
+        final serverService = ref.read(serverServiceProvider.notifier);
+        serverService.adoptSessions({
+          for (final peer in peers)
+            peer.sessionId: (
+              resumeSequence: peer.resumeSequence,
+              key: peer.sessionKey,
+            ),
+        });
+        // Recorded until they reconnect or the server forgets them, so a
+        // second crash before then can still resume them
+        _restoredPeers.addAll({for (final peer in peers) peer.sessionId: peer});
+        _restoredPeersExpiry = Timer(ServerService.resumeGracePeriod, () {
+          _forgetRestoredPeers();
+          _scheduleWrite();
+        });
+        final info = await serverService.start(
+          port: snapshot['localPort'] as int,
+        );
+        if (info != null) {
+          await ref.read(broadcastServiceProvider.notifier).start(info);
+        }
+        break;
+      case SessionRole.client:
+        final peer = peers.firstOrNull;
+        if (peer == null) {
+          return;
+        }
+        // Retries in the background while the old server may still be
+        // restarting; recording starts meanwhile and keeps the peer
+        final server = ServerInfo(
+          id: peer.peerId,
+          name: peer.name,
+          host: peer.host,
+          port: peer.port,
+          isOnline: true,
+        );
+        unawaited(
+          ref
+              .read(clientServiceProvider.notifier)
+              .resume(
+                server,
+                sessionId: peer.sessionId,
+                sessionKey: peer.sessionKey,
+                resumeSequence: peer.resumeSequence + 1,
+              )
+              .then(
+                (_) => logger.info(
+                  '♻️ Resumed client session with ${server.name} '
+                  'in ${clock.elapsedMilliseconds} ms',
+                ),
+                onError: (Object error) =>
+                    logger.error('❌ Failed to resume session: $error'),
+              ),
+        );
+        return;
+      case SessionRole.none:
+        return;
+    }
+
+    logger.info(
+      '♻️ Resumed ${role.name} session with ${peers.length} peer(s) '
+      'in ${clock.elapsedMilliseconds} ms',
+    );
+  }
+
+  /// Coalesce bursts of changes, e.g. many clients dropping at once, into
+  /// a single write
+  void _scheduleWrite() {
+    if (state != SessionServiceState.recording || _writeScheduled) {
+      return;
+    }
+    _writeScheduled = true;
+    scheduleMicrotask(() {
+      _writeScheduled = false;
+      _write();
+    });
+  }
+
+  Future<void> _write() async {
+    final serverService = ref.read(serverServiceProvider.notifier);
+    final clientService = ref.read(clientServiceProvider.notifier);
+    final connectedServer = clientService.connectedServer;
+
+    final serverState = ref.read(serverServiceProvider);
+    final clientState = ref.read(clientServiceProvider);
+
+    var role = SessionRole.none;
+    int? localPort;
+    final peers = <SessionPeer>[];
+    if (serverState == ServerServiceState.running) {
+      role = SessionRole.server;
+      localPort = serverService.serverInfo?.port;
+      for (final id in _clients.keys) {
+        final client = _clients[id]!;
+        peers.add((
+          peerId: id,
+          sessionId: id,
+          sessionKey: serverService.sessionKey(id) ?? '',
+          name: client.name,
+          host: null,
+          port: client.port,
+          resumeSequence: serverService.resumeSequence(id),
+        ));
+      }
+      _restoredPeers.removeWhere((id, _) => _clients[id] != null);
+      for (final peer in _restoredPeers.values) {
+        peers.add((
+          peerId: peer.peerId,
+          sessionId: peer.sessionId,
+          sessionKey: peer.sessionKey,
+          name: peer.name,
+          host: peer.host,
+          port: peer.port,
+          resumeSequence: serverService.resumeSequence(peer.sessionId),
+        ));
+      }
+    } else if ((clientState == ClientServiceState.connected ||
+            clientState == ClientServiceState.connecting) &&
+        connectedServer != null &&
+        clientService.sessionId != null &&
+        clientService.sessionKey != null) {
+      // A dropped connection is connecting again under the same session
+      role = SessionRole.client;
+      peers.add((
+        peerId: connectedServer.id,
+        sessionId: clientService.sessionId!,
+        sessionKey: clientService.sessionKey!,
+        name: connectedServer.name,
+        host: connectedServer.host,
+        port: connectedServer.port,
+        resumeSequence: clientService.resumeSequence,
+      ));
+    }
+
+    try {
+      await _channel.invokeMethod<void>('update', {
+        'role': role.index,
+        'localPort': ?localPort,
+        'peers': [for (final peer in peers) _encodePeer(peer)],
+      });
+    } on PlatformException catch (error) {
+      logger.error('❌ Failed to record session: ${error.message}');
+    }
+  }
+
+  void _forgetRestoredPeers() {
+    _restoredPeersExpiry?.cancel();
+    _restoredPeersExpiry = null;
+    _restoredPeers.clear();
+  }
+
+  static Map<String, dynamic> _encodePeer(SessionPeer peer) => {
+    'peerId': peer.peerId,
+    'sessionId': peer.sessionId,
+    'sessionKey': peer.sessionKey,
+    'name': peer.name,
+    'host': ?peer.host,
+    'port': ?peer.port,
+    'resumeSequence': peer.resumeSequence,
+  };
+
+  static SessionPeer _decodePeer(Map<String, dynamic> map) {
+    final host = map['host'] as String;
+    final port = map['port'] as int;
+    return (
+      peerId: map['peerId'] as String,
+      sessionId: map['sessionId'] as String,
+      sessionKey: map['sessionKey'] as String,
+      name: map['name'] as String,
+      host: host.isEmpty ? null : host,
+      port: port == 0 ? null : port,
+      resumeSequence: map['resumeSequence'] as int,
+    );
+  }
+}
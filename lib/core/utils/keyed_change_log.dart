@@ -0,0 +1,188 @@
+import 'dart:async';
+import 'dart:collection';
+
+/// A versioned change to a keyed collection
+sealed class KeyedChange<T> {
+  const KeyedChange(this.version);
+
+  /// Version of the collection after this change
+  final int version;
+}
+
+/// The whole collection, sent once to each new subscriber
+final class KeyedSnapshot<T> extends KeyedChange<T> {
+  const KeyedSnapshot(super.version, this.items);
+
+  final Map<String, T> items;
+}
+
+final class KeyedAdded<T> extends KeyedChange<T> {
+  const KeyedAdded(super.version, this.key, this.value);
+
+  final String key;
+  final T value;
+}
+
+final class KeyedUpdated<T> extends KeyedChange<T> {
+  const KeyedUpdated(super.version, this.key, this.value);
+
+  final String key;
+  final T value;
+}
+
+final class KeyedRemoved<T> extends KeyedChange<T> {
+  const KeyedRemoved(super.version, this.key);
+
+  final String key;
+}
+
+/// A keyed collection that publishes its changes instead of its contents.
+///
+/// Each subscriber to [changes] first receives a [KeyedSnapshot] and then
+/// only the deltas, so a connect or disconnect costs one small event per
+/// subscriber rather than a copy of the whole collection.
+class KeyedChangeLog<T> {
+  /// [onCancel] runs when the last subscriber goes away
+  KeyedChangeLog({void Function()? onCancel})
+    : _controller = StreamController<KeyedChange<T>>.broadcast(
+        sync: true,
+        onCancel: onCancel,
+      );
+
+  final StreamController<KeyedChange<T>> _controller;
+  final Map<String, T> _items = {};
+  int _version = 0;
+
+  int get version => _version;
+  int get length => _items.length;
+  bool get isEmpty => _items.isEmpty;
+  Iterable<String> get keys => _items.keys;
+  Iterable<T> get values => _items.values;
+
+  T? operator [](String key) => _items[key];
+
+  /// A snapshot followed by every later change
+  Stream<KeyedChange<T>> changes() {
+    return Stream.multi((listener) {
+      // Taking the snapshot and subscribing happen in the same turn, so no
+      // delta can fall between the two
+      listener.add(KeyedSnapshot(_version, Map.unmodifiable(_items)));
+      final subscription = _controller.stream.listen(
+        listener.addSync,
+        onDone: listener.closeSync,
+      );
+      listener.onCancel = subscription.cancel;
+    });
+  }
+
+  /// Add or replace the value stored under [key]
+  void put(String key, T value) {
+    final isNew = !_items.containsKey(key);
+    _items[key] = value;
+    _version++;
+    _emit(
+      isNew
+          ? KeyedAdded(_version, key, value)
+          : KeyedUpdated(_version, key, value),
+    );
+  }
+
+  /// Remove [key], returning its value if it was present
+  T? remove(String key) {
+    if (!_items.containsKey(key)) {
+      return null;
+    }
+    final value = _items.remove(key);
+    _version++;
+    _emit(KeyedRemoved(_version, key));
+    return value;
+  }
+
+  /// Remove every entry, one delta each
+  void clear() {
+    for (final key in _items.keys.toList()) {
+      remove(key);
+    }
+  }
+
+  Future<void> close() => _controller.close();
+
+  void _emit(KeyedChange<T> change) {
+    if (!_controller.isClosed) {
+      _controller.add(change);
+    }
+  }
+}
+
+/// Local replica of a [KeyedChangeLog], kept up to date by [apply].
+///
+/// Entries keep their insertion order. Changes at or below the replica's
+/// version are ignored, so a late duplicate cannot roll it back.
+class KeyedView<T> {
+  /// Only keys accepted by [where] are kept
+  KeyedView({bool Function(String key)? where}) : _where = where;
+
+  final bool Function(String key)? _where;
+  final LinkedHashMap<String, T> _items = LinkedHashMap();
+  List<String>? _keys;
+  int _version = -1;
+
+  int get version => _version;
+  int get length => _items.length;
+  bool get isEmpty => _items.isEmpty;
+  Iterable<T> get values => _items.values;
+
+  /// Keys in insertion order; rebuilt only after an add or remove
+  List<String> get keys => _keys ??= List.unmodifiable(_items.keys);
+
+  T? operator [](String key) => _items[key];
+
+  bool containsKey(String key) => _items.containsKey(key);
+
+  /// Forget everything, e.g. when the source goes away; the next
+  /// [KeyedSnapshot] starts the replica over
+  void clear() {
+    _items.clear();
+    _keys = null;
+    _version = -1;
+  }
+
+  /// Apply [change], returning whether the visible contents changed
+  bool apply(KeyedChange<T> change) {
+    if (change is! KeyedSnapshot<T> && change.version <= _version) {
+      return false;
+    }
+    _version = change.version;
+
+    switch (change) {
+      case KeyedSnapshot(:final items):
+        _items.clear();
+        for (final entry in items.entries) {
+          if (_accepts(entry.key)) {
+            _items[entry.key] = entry.value;
+          }
+        }
+        _keys = null;
+        return true;
+      case KeyedAdded(:final key, :final value):
+      case KeyedUpdated(:final key, :final value):
+        if (!_accepts(key)) {
+          return false;
+        }
+        if (!_items.containsKey(key)) {
+          _keys = null;
+        }
+        _items[key] = value;
+        return true;
+      case KeyedRemoved(:final key):
+        if (!_items.containsKey(key)) {
+          return false;
+        }
+        _items.remove(key);
+        _keys = null;
+        return true;
+    }
+  }
+
+  bool _accepts(String key) => _where?.call(key) ?? true;
+}
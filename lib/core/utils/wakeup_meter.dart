@@ -0,0 +1,65 @@
+import 'dart:io';
+
+/// Measures how often this process wakes up, using the voluntary context
+/// switch counters of all its threads (Linux only).
+///
+/// Every voluntary switch is a thread going to sleep, so the rate is a good
+/// proxy for timer and socket wakeups without instrumenting every timer.
+/// The counters are read asynchronously, so measuring never blocks the
+/// caller on procfs.
+class WakeupMeter {
+  WakeupMeter() {
+    _clock.start();
+    _lap = _readSwitches().then((switches) {
+      _startSwitches = switches;
+      return null;
+    });
+  }
+
+  final Stopwatch _clock = Stopwatch();
+  int? _startSwitches;
+  late Future<double?> _lap;
+
+  /// Whether the platform exposes the counters
+  static bool get isSupported => Platform.isLinux;
+
+  /// End the current measurement window and begin the next one.
+  ///
+  /// Completes with the average wakeups per second over the window that
+  /// ended, or `null` if unknown. Laps are measured in call order.
+  Future<double?> lap() {
+    final seconds = _clock.elapsedMicroseconds / Duration.microsecondsPerSecond;
+    _clock
+      ..reset()
+      ..start();
+    return _lap = _lap.then((_) async {
+      final start = _startSwitches;
+      final end = await _readSwitches();
+      _startSwitches = end;
+      if (start == null || end == null || seconds <= 0) {
+        return null;
+      }
+      return (end - start) / seconds;
+    });
+  }
+
+  static Future<int?> _readSwitches() async {
+    if (!isSupported) {
+      return null;
+    }
+    try {
+      var total = 0;
+      await for (final task in Directory('/proc/self/task').list()) {
+        final status = await File('${task.path}/status').readAsLines();
+        for (final line in status) {
+          if (line.startsWith('voluntary_ctxt_switches:')) {
+            total += int.parse(line.split(':').last.trim());
+          }
+        }
+      }
+      return total;
+    } on FileSystemException {
+      return null;
+    }
+  }
+}
@@ -0,0 +1,48 @@
+import 'package:desk_switch/core/services/idle_service.dart';
+import 'package:flutter/material.dart';
+import 'package:flutter/services.dart';
+import 'package:flutter_hooks/flutter_hooks.dart';
+import 'package:hooks_riverpod/hooks_riverpod.dart';
+
+/// Reports local pointer, keyboard and window activity to [IdleService], so
+/// the app leaves idle mode (and discovery resumes) as soon as someone uses
+/// it, even without a peer connection.
+class ActivityListener extends HookConsumerWidget {
+  const ActivityListener({
+    super.key,
+    required this.child,
+  });
+
+  final Widget child;
+
+  @override
+  Widget build(BuildContext context, WidgetRef ref) {
+    final idleService = ref.read(idleServiceProvider.notifier);
+
+    useEffect(() {
+      bool onKey(KeyEvent event) {
+        idleService.markActivity();
+        return false;
+      }
+
+      HardwareKeyboard.instance.addHandler(onKey);
+      final lifecycle = AppLifecycleListener(
+        onShow: idleService.markActivity,
+        onResume: idleService.markActivity,
+      );
+      return () {
+        HardwareKeyboard.instance.removeHandler(onKey);
+        lifecycle.dispose();
+      };
+    }, [idleService]);
+
+    return Listener(
+      behavior: HitTestBehavior.translucent,
+      onPointerDown: (_) => idleService.markActivity(),
+      onPointerMove: (_) => idleService.markActivity(),
+      onPointerHover: (_) => idleService.markActivity(),
+      onPointerSignal: (_) => idleService.markActivity(),
+      child: child,
+    );
+  }
+}
@@ -1,3 +1,4 @@
+import 'package:desk_switch/core/services/edge_barrier_service.dart';
 import 'package:flutter/material.dart';
 import 'package:flutter_hooks/flutter_hooks.dart';
 import 'package:hooks_riverpod/hooks_riverpod.dart';
@@ -8,11 +9,15 @@ class KvmDisplay {
   Offset position;
   final Size size;
 
+  /// Whether this is the machine the app runs on
+  final bool isLocal;
+
   KvmDisplay({
     required this.id,
     required this.name,
     required this.position,
     required this.size,
+    this.isLocal = false,
   });
 
   KvmDisplay copyWith({Offset? position}) => KvmDisplay(
@@ -20,6 +25,7 @@ class KvmDisplay {
     name: name,
     position: position ?? this.position,
     size: size,
+    isLocal: isLocal,
   );
 
   Rect get rect =>
@@ -38,6 +44,57 @@ class KvmDisplayArrangement {
           .toList(),
     );
   }
+
+  /// ID of the display marked [KvmDisplay.isLocal], if any
+  String? get localId {
+    for (final display in displays) {
+      if (display.isLocal) {
+        return display.id;
+      }
+    }
+    return null;
+  }
+
+  /// Segments of [localId]'s border that touch another display.
+  ///
+  /// Targets number the displays in list order with [localId] as `0`,
+  /// matching the focus switcher.
+  List<ScreenEdge> adjacentEdges(String localId, {double tolerance = 1}) {
+    final local = displays.firstWhere((d) => d.id == localId);
+    final others = displays.where((d) => d.id != localId).toList();
+    final rect = local.rect;
+    final edges = <ScreenEdge>[];
+
+    for (final (index, other) in others.indexed) {
+      final target = index + 1;
+      final o = other.rect;
+
+      ScreenSide? side;
+      if ((o.left - rect.right).abs() <= tolerance) {
+        side = ScreenSide.right;
+      } else if ((o.right - rect.left).abs() <= tolerance) {
+        side = ScreenSide.left;
+      } else if ((o.top - rect.bottom).abs() <= tolerance) {
+        side = ScreenSide.bottom;
+      } else if ((o.bottom - rect.top).abs() <= tolerance) {
+        side = ScreenSide.top;
+      }
+      if (side == null) {
+        continue;
+      }
+
+      final vertical = side == ScreenSide.left || side == ScreenSide.right;
+      final (from, to, length) = vertical
+          ? (o.top - rect.top, o.bottom - rect.top, rect.height)
+          : (o.left - rect.left, o.right - rect.left, rect.width);
+      final start = (from / length).clamp(0.0, 1.0);
+      final end = (to / length).clamp(0.0, 1.0);
+      if (end > start) {
+        edges.add((side: side, start: start, end: end, target: target));
+      }
+    }
+    return edges;
+  }
 }
 
 class ArrangeDisplaysDialog extends HookConsumerWidget {
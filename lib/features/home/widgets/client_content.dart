@@ -1,4 +1,5 @@
 import 'package:desk_switch/core/services/client_service.dart';
+import 'package:desk_switch/core/services/cursor_prediction_service.dart';
 import 'package:desk_switch/core/services/discovery_service.dart';
 import 'package:desk_switch/features/home/widgets/client_content_providers.dart';
 import 'package:desk_switch/features/home/widgets/server_card.dart';
@@ -335,10 +336,11 @@ class _ServerList extends HookConsumerWidget {
                     padding: const EdgeInsets.only(top: 0, bottom: 32),
                     itemCount: servers.length,
                     itemBuilder: (context, index) {
-                      final server = servers[index];
+                      final server = servers[servers.keys[index]]!;
                       final isPinned = pinnedNotifier.isPinned(server.name);
 
                       return ServerCard(
+                        key: ValueKey(server.id),
                         server: server,
                         isSelected: selectedServer?.id == server.id,
                         isPinned: isPinned,
@@ -710,6 +712,10 @@ class _ConnectionStatus extends HookConsumerWidget {
                 ),
               ],
             ),
+            if (isConnected) ...[
+              const Gap(8),
+              const _CursorPrediction(),
+            ],
             const Gap(16),
             const _ConnectButton(),
           ],
@@ -718,3 +724,43 @@ class _ConnectionStatus extends HookConsumerWidget {
     );
   }
 }
+
+class _CursorPrediction extends HookConsumerWidget {
+  const _CursorPrediction();
+
+  @override
+  Widget build(BuildContext context, WidgetRef ref) {
+    final predictionState = ref.watch(cursorPredictionServiceProvider);
+    final predictionService = ref.read(
+      cursorPredictionServiceProvider.notifier,
+    );
+    final stats = ref.watch(cursorPredictionStatsProvider).value;
+    final isEnabled =
+        predictionState != CursorPredictionServiceState.disabled;
+
+    return Row(
+      children: [
+        Expanded(
+          child: _InfoRow(
+            label: 'Cursor prediction error',
+            value: !isEnabled
+                ? 'Prediction off'
+                : stats == null || stats.count == 0
+                ? 'No samples yet'
+                : 'p50 ≤ ${stats.quantile(0.5).toStringAsFixed(0)} px · '
+                      'p95 ≤ ${stats.quantile(0.95).toStringAsFixed(0)} px · '
+                      'max ${stats.max.toStringAsFixed(1)} px',
+            icon: Icons.near_me,
+          ),
+        ),
+        Tooltip(
+          message: 'Predict cursor motion to hide network latency',
+          child: Switch(
+            value: isEnabled,
+            onChanged: predictionService.setEnabled,
+          ),
+        ),
+      ],
+    );
+  }
+}
@@ -1,41 +1,62 @@
 import 'dart:async';
 
+import 'package:desk_switch/core/input/cursor_predictor.dart';
+import 'package:desk_switch/core/services/cursor_prediction_service.dart';
 import 'package:desk_switch/core/services/discovery_service.dart';
 import 'package:desk_switch/core/services/system_service.dart';
+import 'package:desk_switch/core/utils/keyed_change_log.dart';
 import 'package:desk_switch/models/server_info.dart';
 import 'package:riverpod_annotation/riverpod_annotation.dart';
 import 'package:shared_preferences/shared_preferences.dart';
 
 part 'client_content_providers.g.dart';
 
-// Provider for the list of online servers (future: combine with pins)
+// Provider for the online servers (future: combine with pins). Discovery
+// deltas are applied in place, so a flapping server costs one notification
+// rather than a rebuilt list
 @Riverpod(keepAlive: true)
-Stream<List<ServerInfo>> servers(Ref ref) async* {
-  final discoveryService = ref.watch(discoveryServiceProvider.notifier);
-  // final clientService = ref.watch(clientServiceProvider.notifier);
-  final systemService = ref.watch(systemServiceProvider.notifier);
-  final currentMachineId = await systemService.getMachineId();
-  yield* discoveryService.discover().asyncMap((serverList) {
-    return Future.value(
-      serverList.where((server) => server.id != currentMachineId).toList(),
+class Servers extends _$Servers {
+  @override
+  Future<KeyedView<ServerInfo>> build() async {
+    final discoveryService = ref.watch(discoveryServiceProvider.notifier);
+    final systemService = ref.watch(systemServiceProvider.notifier);
+    final currentMachineId = await systemService.getMachineId();
+
+    // Filter out the current machine from the discovered servers
+    final servers = KeyedView<ServerInfo>(
+      where: (id) => id != currentMachineId,
     );
-  });
-
-  // ref.onDispose(() => discoveryService.stop());
-
-  // await for (final serverList in discoveredServers) {
-  //   // Filter out the current machine from the discovered servers
-  //   final filteredServers = serverList
-  //       .where(
-  //         (server) => server.id != currentMachineId,
-  //       )
-  //       .toList();
+    final snapshot = Completer<void>();
+    final subscription = discoveryService.discover().listen(
+      (change) {
+        if (!servers.apply(change)) {
+          return;
+        }
+        if (snapshot.isCompleted) {
+          ref.notifyListeners();
+        } else {
+          snapshot.complete();
+        }
+      },
+      onError: (Object error, StackTrace stackTrace) {
+        if (!snapshot.isCompleted) {
+          snapshot.completeError(error, stackTrace);
+        }
+      },
+    );
+    ref.onDispose(subscription.cancel);
 
-  //   // Trigger auto-connect for available servers
-  //   // await clientService.handleAutoConnect(filteredServers);
+    await snapshot.future;
+    return servers;
+  }
+}
 
-  //   yield filteredServers;
-  // }
+// Provider for the cursor prediction error distribution
+@riverpod
+Stream<PredictionStats> cursorPredictionStats(Ref ref) async* {
+  final predictionService = ref.watch(cursorPredictionServiceProvider.notifier);
+  yield predictionService.currentStats;
+  yield* predictionService.stats();
 }
 
 // Notifier for selected server with availability checking
@@ -54,9 +75,7 @@ class SelectedServer extends _$SelectedServer {
           if (currentServer == null) return null;
 
           // Check if the current server is still available and online
-          final isStillAvailable = servers.any(
-            (server) => server.id == currentServer.id,
-          );
+          final isStillAvailable = servers.containsKey(currentServer.id);
 
           // If server is no longer available, return null (unselect it)
           if (!isStillAvailable) return null;
@@ -1,3 +1,4 @@
+import 'package:desk_switch/core/services/edge_barrier_service.dart';
 import 'package:desk_switch/features/home/widgets/arrange_displays_dialog.dart';
 import 'package:desk_switch/features/home/widgets/server_content_providers.dart';
 import 'package:desk_switch/models/server_info.dart';
@@ -330,6 +331,7 @@ class _MonitorArrangementButton extends HookConsumerWidget {
                 KvmDisplay(
                   id: '1',
                   name: 'Primary Display',
+                  isLocal: true,
                   // resolution: '1920x1080',
                   size: const Size(192, 108),
                   position: const Offset(0, 0),
@@ -348,7 +350,14 @@ class _MonitorArrangementButton extends HookConsumerWidget {
                 ),
               ],
             ),
-            onArrangementChanged: (arrangement) {},
+            onArrangementChanged: (arrangement) {
+              final localId = arrangement.localId;
+              ref
+                  .read(edgeBarrierServiceProvider.notifier)
+                  .setEdges(
+                    localId == null ? [] : arrangement.adjacentEdges(localId),
+                  );
+            },
           ),
         );
       },
@@ -640,15 +649,17 @@ class _ClientList extends HookConsumerWidget {
                               ),
                             ),
                           )
-                        : ListView(
-                            children: clients
-                                .map(
-                                  (c) => ListTile(
-                                    leading: const Icon(Icons.computer),
-                                    title: Text(c.name ?? c.id),
-                                  ),
-                                )
-                                .toList(),
+                        : ListView.builder(
+                            itemCount: clients.length,
+                            itemBuilder: (context, index) {
+                              final id = clients.keys[index];
+                              final client = clients[id]!;
+                              return ListTile(
+                                key: ValueKey(id),
+                                leading: const Icon(Icons.computer),
+                                title: Text(client.name),
+                              );
+                            },
                           ),
                     loading: () =>
                         const Center(child: CircularProgressIndicator()),
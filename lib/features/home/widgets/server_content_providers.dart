@@ -1,5 +1,8 @@
+import 'dart:async';
+
 import 'package:desk_switch/core/services/server_service.dart';
 import 'package:desk_switch/core/services/system_service.dart';
+import 'package:desk_switch/core/utils/keyed_change_log.dart';
 import 'package:desk_switch/models/client_info.dart';
 import 'package:desk_switch/models/server_info.dart';
 import 'package:riverpod_annotation/riverpod_annotation.dart';
@@ -9,12 +12,30 @@ export 'package:desk_switch/core/services/server_service.dart';
 
 part 'server_content_providers.g.dart';
 
-// Provider for clients
+// Provider for clients, kept current by applying the server's deltas in
+// place; listeners are notified without a new list being built
 @riverpod
-Stream<List<ClientInfo>> clients(Ref ref) async* {
-  final serverService = ref.watch(serverServiceProvider.notifier);
-  yield serverService.currentClients;
-  yield* serverService.clients();
+class Clients extends _$Clients {
+  @override
+  Future<KeyedView<ClientInfo>> build() async {
+    final serverService = ref.watch(serverServiceProvider.notifier);
+    final clients = KeyedView<ClientInfo>();
+    final snapshot = Completer<void>();
+    final subscription = serverService.clientChanges().listen((change) {
+      if (!clients.apply(change)) {
+        return;
+      }
+      if (snapshot.isCompleted) {
+        ref.notifyListeners();
+      } else {
+        snapshot.complete();
+      }
+    });
+    ref.onDispose(subscription.cancel);
+
+    await snapshot.future;
+    return clients;
+  }
 }
 
 // Provider for whether the server is running
@@ -1,6 +1,12 @@
 import 'dart:io';
 
+import 'package:desk_switch/core/services/audio_service.dart';
+import 'package:desk_switch/core/services/focus_switch_service.dart';
+import 'package:desk_switch/core/services/pointer_service.dart';
+import 'package:desk_switch/core/services/scroll_service.dart';
+import 'package:desk_switch/core/services/session_service.dart';
 import 'package:desk_switch/core/utils/logger.dart';
+import 'package:desk_switch/features/app/widgets/activity_listener.dart';
 import 'package:desk_switch/l10n/app_localizations.dart';
 import 'package:desk_switch/router/app_router.dart';
 import 'package:desk_switch/theme/app_theme.dart';
@@ -62,6 +68,14 @@ class DeskSwitchApp extends ConsumerWidget {
     final router = ref.watch(appRouterProvider);
     final theme = ref.watch(appThemeProvider);
 
+    // These services follow the connection on their own; listening just
+    // keeps them alive without rebuilding the app on their changes
+    ref.listen(audioServiceProvider, (_, _) {});
+    ref.listen(focusSwitchServiceProvider, (_, _) {});
+    ref.listen(pointerServiceProvider, (_, _) {});
+    ref.listen(scrollServiceProvider, (_, _) {});
+    ref.listen(sessionServiceProvider, (_, _) {});
+
     return MaterialApp.router(
       title: 'DeskSwitch',
       routerConfig: router,
@@ -69,6 +83,7 @@ class DeskSwitchApp extends ConsumerWidget {
       supportedLocales: AppLocalizations.supportedLocales,
       theme: theme.lightTheme,
       darkTheme: theme.darkTheme,
+      builder: (context, child) => ActivityListener(child: child!),
     );
   }
 }
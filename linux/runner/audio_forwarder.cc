@@ -0,0 +1,452 @@
+#include "audio_forwarder.h"
+
+#include <opus.h>
+#include <pulse/error.h>
+#include <pulse/simple.h>
+
+#include <cstring>
+
+#include "jitter_buffer.h"
+
+// 48 kHz stereo in 10 ms frames keeps Opus in its lowest-delay mode.
+static const int kSampleRate = 48000;
+static const int kChannels = 2;
+static const int kFrameMs = 10;
+static const int kFrameSamples = kSampleRate * kFrameMs / 1000;
+static const size_t kFrameBytes =
+    kFrameSamples * kChannels * sizeof(opus_int16);
+static const int kMaxPacketBytes = 1500;
+static const int kBitrate = 96000;
+
+struct _AudioForwarder
+{
+  GObject parent_instance;
+  FlMethodChannel *channel;
+
+  GThread *capture_thread;
+  gint capture_running;
+  gchar *capture_source;
+
+  GThread *playback_thread;
+  gint playback_running;
+  // Set by a playback thread that gave up; cleared by stop_playback.
+  gint playback_failed;
+  guint playback_generation;
+  JitterBuffer *jitter_buffer;
+};
+
+G_DEFINE_TYPE(AudioForwarder, audio_forwarder, G_TYPE_OBJECT)
+
+typedef struct
+{
+  AudioForwarder *self;
+  guint32 sequence;
+  GBytes *payload;
+} CapturedPacket;
+
+static void captured_packet_free(gpointer data)
+{
+  CapturedPacket *packet = static_cast<CapturedPacket *>(data);
+  g_object_unref(packet->self);
+  g_bytes_unref(packet->payload);
+  g_free(packet);
+}
+
+// Runs on the main loop: forwards one encoded frame to Dart.
+static gboolean deliver_packet_cb(gpointer data)
+{
+  CapturedPacket *packet = static_cast<CapturedPacket *>(data);
+  AudioForwarder *self = packet->self;
+  if (self->channel == nullptr || !g_atomic_int_get(&self->capture_running))
+  {
+    return G_SOURCE_REMOVE;
+  }
+
+  gsize size = 0;
+  const uint8_t *bytes =
+      static_cast<const uint8_t *>(g_bytes_get_data(packet->payload, &size));
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "sequence",
+                           fl_value_new_int(packet->sequence));
+  fl_value_set_string_take(args, "data", fl_value_new_uint8_list(bytes, size));
+  fl_method_channel_invoke_method(self->channel, "packet", args, nullptr,
+                                  nullptr, nullptr);
+  return G_SOURCE_REMOVE;
+}
+
+static gpointer capture_thread_func(gpointer data)
+{
+  AudioForwarder *self = AUDIO_FORWARDER(data);
+
+  pa_sample_spec spec = {PA_SAMPLE_S16LE, kSampleRate, kChannels};
+  pa_buffer_attr attr;
+  memset(&attr, 0xff, sizeof(attr));
+  attr.fragsize = kFrameBytes;
+
+  int error = 0;
+  pa_simple *stream =
+      pa_simple_new(nullptr, APPLICATION_ID, PA_STREAM_RECORD,
+                    self->capture_source, "Forwarded audio", &spec, nullptr,
+                    &attr, &error);
+  if (stream == nullptr)
+  {
+    g_warning("Failed to open %s: %s", self->capture_source,
+              pa_strerror(error));
+    g_atomic_int_set(&self->capture_running, FALSE);
+    return nullptr;
+  }
+
+  OpusEncoder *encoder = opus_encoder_create(
+      kSampleRate, kChannels, OPUS_APPLICATION_RESTRICTED_LOWDELAY, &error);
+  if (encoder == nullptr)
+  {
+    g_warning("Failed to create Opus encoder: %s", opus_strerror(error));
+    pa_simple_free(stream);
+    g_atomic_int_set(&self->capture_running, FALSE);
+    return nullptr;
+  }
+  opus_encoder_ctl(encoder, OPUS_SET_BITRATE(kBitrate));
+  opus_encoder_ctl(encoder, OPUS_SET_COMPLEXITY(5));
+
+  opus_int16 pcm[kFrameSamples * kChannels];
+  unsigned char encoded[kMaxPacketBytes];
+  guint32 sequence = 0;
+  while (g_atomic_int_get(&self->capture_running))
+  {
+    if (pa_simple_read(stream, pcm, sizeof(pcm), &error) < 0)
+    {
+      g_warning("Audio capture failed: %s", pa_strerror(error));
+      break;
+    }
+
+    opus_int32 length =
+        opus_encode(encoder, pcm, kFrameSamples, encoded, sizeof(encoded));
+    if (length < 0)
+    {
+      g_warning("Opus encoding failed: %s", opus_strerror(length));
+      continue;
+    }
+
+    CapturedPacket *packet = g_new0(CapturedPacket, 1);
+    packet->self = AUDIO_FORWARDER(g_object_ref(self));
+    packet->sequence = sequence++;
+    packet->payload = g_bytes_new(encoded, length);
+    g_main_context_invoke_full(nullptr, G_PRIORITY_HIGH, deliver_packet_cb,
+                               packet, captured_packet_free);
+  }
+
+  opus_encoder_destroy(encoder);
+  pa_simple_free(stream);
+  return nullptr;
+}
+
+typedef struct
+{
+  AudioForwarder *self;
+  guint generation;
+  gchar *message;
+} PlaybackFailure;
+
+static void playback_failure_free(gpointer data)
+{
+  PlaybackFailure *failure = static_cast<PlaybackFailure *>(data);
+  g_object_unref(failure->self);
+  g_free(failure->message);
+  g_free(failure);
+}
+
+// Runs on the main loop: reports a failure unless playback was restarted.
+static gboolean deliver_playback_failure_cb(gpointer data)
+{
+  PlaybackFailure *failure = static_cast<PlaybackFailure *>(data);
+  AudioForwarder *self = failure->self;
+  if (self->channel == nullptr ||
+      failure->generation != self->playback_generation)
+  {
+    return G_SOURCE_REMOVE;
+  }
+
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "message",
+                           fl_value_new_string(failure->message));
+  fl_method_channel_invoke_method(self->channel, "playbackFailed", args,
+                                  nullptr, nullptr, nullptr);
+  return G_SOURCE_REMOVE;
+}
+
+// Called on the playback thread before it exits early. Further packets are
+// rejected until stopPlayback joins the thread.
+static void fail_playback(AudioForwarder *self, guint generation,
+                          const gchar *message)
+{
+  g_warning("%s", message);
+  g_atomic_int_set(&self->playback_failed, TRUE);
+  g_atomic_int_set(&self->playback_running, FALSE);
+
+  PlaybackFailure *failure = g_new0(PlaybackFailure, 1);
+  failure->self = AUDIO_FORWARDER(g_object_ref(self));
+  failure->generation = generation;
+  failure->message = g_strdup(message);
+  g_idle_add_full(G_PRIORITY_DEFAULT, deliver_playback_failure_cb, failure,
+                  playback_failure_free);
+}
+
+static gpointer playback_thread_func(gpointer data)
+{
+  AudioForwarder *self = AUDIO_FORWARDER(data);
+  // Only stop_playback changes it, after joining this thread.
+  guint generation = self->playback_generation;
+
+  // A short server-side buffer: the jitter buffer does the smoothing.
+  pa_sample_spec spec = {PA_SAMPLE_S16LE, kSampleRate, kChannels};
+  pa_buffer_attr attr;
+  memset(&attr, 0xff, sizeof(attr));
+  attr.tlength = 2 * kFrameBytes;
+  attr.prebuf = kFrameBytes;
+
+  int error = 0;
+  pa_simple *stream =
+      pa_simple_new(nullptr, APPLICATION_ID, PA_STREAM_PLAYBACK, nullptr,
+                    "Remote audio", &spec, nullptr, &attr, &error);
+  if (stream == nullptr)
+  {
+    g_autofree gchar *message =
+        g_strdup_printf("Failed to open playback: %s", pa_strerror(error));
+    fail_playback(self, generation, message);
+    return nullptr;
+  }
+
+  OpusDecoder *decoder = opus_decoder_create(kSampleRate, kChannels, &error);
+  if (decoder == nullptr)
+  {
+    g_autofree gchar *message = g_strdup_printf(
+        "Failed to create Opus decoder: %s", opus_strerror(error));
+    pa_simple_free(stream);
+    fail_playback(self, generation, message);
+    return nullptr;
+  }
+
+  opus_int16 pcm[kFrameSamples * kChannels];
+  while (g_atomic_int_get(&self->playback_running))
+  {
+    g_autoptr(GBytes) payload = nullptr;
+    int samples = 0;
+    switch (jitter_buffer_pop(self->jitter_buffer, &payload))
+    {
+    case JITTER_BUFFER_FRAME:
+    {
+      gsize size = 0;
+      const unsigned char *bytes =
+          static_cast<const unsigned char *>(g_bytes_get_data(payload, &size));
+      samples = opus_decode(decoder, bytes, size, pcm, kFrameSamples, 0);
+      break;
+    }
+    case JITTER_BUFFER_LOST:
+      // Packet loss concealment
+      samples = opus_decode(decoder, nullptr, 0, pcm, kFrameSamples, 0);
+      break;
+    case JITTER_BUFFER_EMPTY:
+      break;
+    }
+    if (samples <= 0)
+    {
+      memset(pcm, 0, sizeof(pcm));
+    }
+
+    // Blocks for roughly one frame, which paces the loop.
+    if (pa_simple_write(stream, pcm, sizeof(pcm), &error) < 0)
+    {
+      g_autofree gchar *message =
+          g_strdup_printf("Audio playback failed: %s", pa_strerror(error));
+      fail_playback(self, generation, message);
+      break;
+    }
+  }
+
+  opus_decoder_destroy(decoder);
+  pa_simple_free(stream);
+  return nullptr;
+}
+
+static void stop_capture(AudioForwarder *self)
+{
+  g_atomic_int_set(&self->capture_running, FALSE);
+  if (self->capture_thread != nullptr)
+  {
+    g_thread_join(self->capture_thread);
+    self->capture_thread = nullptr;
+  }
+}
+
+static void stop_playback(AudioForwarder *self)
+{
+  g_atomic_int_set(&self->playback_running, FALSE);
+  if (self->playback_thread != nullptr)
+  {
+    g_thread_join(self->playback_thread);
+    self->playback_thread = nullptr;
+  }
+  // Drops failure reports still queued from the thread that was joined.
+  self->playback_generation++;
+  g_atomic_int_set(&self->playback_failed, FALSE);
+  jitter_buffer_reset(self->jitter_buffer);
+}
+
+static FlMethodResponse *start_capture(AudioForwarder *self, FlValue *args)
+{
+  stop_capture(self);
+
+  FlValue *source = fl_value_get_type(args) == FL_VALUE_TYPE_MAP
+                        ? fl_value_lookup_string(args, "source")
+                        : nullptr;
+  g_free(self->capture_source);
+  self->capture_source = g_strdup(
+      source != nullptr ? fl_value_get_string(source) : "@DEFAULT_MONITOR@");
+
+  g_atomic_int_set(&self->capture_running, TRUE);
+  self->capture_thread =
+      g_thread_new("audio-capture", capture_thread_func, self);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+static FlMethodResponse *play(AudioForwarder *self, FlValue *args)
+{
+  FlValue *sequence = fl_value_lookup_string(args, "sequence");
+  FlValue *data = fl_value_lookup_string(args, "data");
+  if (sequence == nullptr || data == nullptr ||
+      fl_value_get_type(data) != FL_VALUE_TYPE_UINT8_LIST)
+  {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad-args", "play expects sequence and data", nullptr));
+  }
+
+  if (g_atomic_int_get(&self->playback_failed))
+  {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "playback-failed", "Playback failed; stopPlayback to retry",
+        nullptr));
+  }
+
+  // Playback starts with the first packet and runs until stopPlayback.
+  if (self->playback_thread == nullptr)
+  {
+    g_atomic_int_set(&self->playback_running, TRUE);
+    self->playback_thread =
+        g_thread_new("audio-playback", playback_thread_func, self);
+  }
+
+  g_autoptr(GBytes) payload = g_bytes_new(fl_value_get_uint8_list(data),
+                                          fl_value_get_length(data));
+  jitter_buffer_push(self->jitter_buffer, fl_value_get_int(sequence), payload,
+                     g_get_monotonic_time());
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+static FlMethodResponse *get_stats(AudioForwarder *self)
+{
+  JitterBufferStats stats;
+  jitter_buffer_get_stats(self->jitter_buffer, &stats);
+
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "depthMs",
+                           fl_value_new_int(stats.depth * kFrameMs));
+  fl_value_set_string_take(result, "targetMs",
+                           fl_value_new_int(stats.target * kFrameMs));
+  fl_value_set_string_take(result, "jitterMs",
+                           fl_value_new_float(stats.jitter_ms));
+  fl_value_set_string_take(result, "underruns",
+                           fl_value_new_int(stats.underruns));
+  fl_value_set_string_take(result, "late", fl_value_new_int(stats.late));
+  fl_value_set_string_take(result, "lost", fl_value_new_int(stats.lost));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static void method_call_cb(FlMethodChannel *channel, FlMethodCall *method_call,
+                           gpointer user_data)
+{
+  AudioForwarder *self = AUDIO_FORWARDER(user_data);
+  const gchar *method = fl_method_call_get_name(method_call);
+  FlValue *args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "startCapture") == 0)
+  {
+    response = start_capture(self, args);
+  }
+  else if (strcmp(method, "stopCapture") == 0)
+  {
+    stop_capture(self);
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+  }
+  else if (strcmp(method, "play") == 0 &&
+           fl_value_get_type(args) == FL_VALUE_TYPE_MAP)
+  {
+    response = play(self, args);
+  }
+  else if (strcmp(method, "stopPlayback") == 0)
+  {
+    stop_playback(self);
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+  }
+  else if (strcmp(method, "getStats") == 0)
+  {
+    response = get_stats(self);
+  }
+  else
+  {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error))
+  {
+    g_warning("Failed to respond to %s: %s", method, error->message);
+  }
+}
+
+// Implements GObject::dispose.
+static void audio_forwarder_dispose(GObject *object)
+{
+  AudioForwarder *self = AUDIO_FORWARDER(object);
+
+  stop_capture(self);
+  if (self->jitter_buffer != nullptr)
+  {
+    stop_playback(self);
+  }
+  g_clear_pointer(&self->jitter_buffer, jitter_buffer_free);
+  g_clear_pointer(&self->capture_source, g_free);
+
+  if (self->channel != nullptr)
+  {
+    fl_method_channel_set_method_call_handler(self->channel, nullptr, nullptr,
+                                              nullptr);
+  }
+  g_clear_object(&self->channel);
+
+  G_OBJECT_CLASS(audio_forwarder_parent_class)->dispose(object);
+}
+
+static void audio_forwarder_class_init(AudioForwarderClass *klass)
+{
+  G_OBJECT_CLASS(klass)->dispose = audio_forwarder_dispose;
+}
+
+static void audio_forwarder_init(AudioForwarder *self)
+{
+  // 20 ms minimum keeps one frame of slack; 200 ms caps the latency.
+  self->jitter_buffer = jitter_buffer_new(kFrameMs, 2, 20);
+}
+
+AudioForwarder *audio_forwarder_new(FlBinaryMessenger *messenger)
+{
+  AudioForwarder *self =
+      AUDIO_FORWARDER(g_object_new(audio_forwarder_get_type(), nullptr));
+
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  self->channel = fl_method_channel_new(messenger, "desk_switch/audio",
+                                        FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(self->channel, method_call_cb,
+                                            self, nullptr);
+  return self;
+}
@@ -0,0 +1,29 @@
+#ifndef FLUTTER_AUDIO_FORWARDER_H_
+#define FLUTTER_AUDIO_FORWARDER_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <gtk/gtk.h>
+
+G_DECLARE_FINAL_TYPE(AudioForwarder, audio_forwarder, AUDIO, FORWARDER,
+                     GObject)
+
+/**
+ * audio_forwarder_new:
+ * @messenger: the engine's binary messenger.
+ *
+ * Creates the audio forwarder behind the `desk_switch/audio` method
+ * channel.
+ *
+ * On the controlled machine, `startCapture` records the PulseAudio (or
+ * PipeWire-Pulse) monitor source. It encodes 10 ms Opus frames on a capture
+ * thread and hands each one to Dart as a `packet` call. On the machine
+ * with the speakers, `play` feeds received packets into an adaptive
+ * #JitterBuffer that a playback thread drains in real time. If playback
+ * fails, Dart is told with `playbackFailed` and further packets are
+ * rejected until `stopPlayback`.
+ *
+ * Returns: a new #AudioForwarder.
+ */
+AudioForwarder* audio_forwarder_new(FlBinaryMessenger* messenger);
+
+#endif  // FLUTTER_AUDIO_FORWARDER_H_
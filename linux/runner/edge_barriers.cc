@@ -0,0 +1,352 @@
+#include "edge_barriers.h"
+
+#include <cstring>
+
+#include "edge_filter.h"
+
+#ifdef GDK_WINDOWING_X11
+#include <X11/Xlib.h>
+#include <X11/extensions/XInput2.h>
+#include <X11/extensions/Xfixes.h>
+#include <gdk/gdkx.h>
+#endif
+
+typedef struct
+{
+  EdgeFilter filter;
+  gint target;
+  gulong barrier;
+} Edge;
+
+struct _EdgeBarriers
+{
+  GObject parent_instance;
+  FlMethodChannel *channel;
+  FocusSwitcher *switcher;
+  GArray *edges;
+  gint xi_opcode;
+};
+
+G_DEFINE_TYPE(EdgeBarriers, edge_barriers, G_TYPE_OBJECT)
+
+#ifdef GDK_WINDOWING_X11
+static Display *get_xdisplay()
+{
+  GdkDisplay *display = gdk_display_get_default();
+  if (display == nullptr || !GDK_IS_X11_DISPLAY(display))
+  {
+    return nullptr;
+  }
+  return GDK_DISPLAY_XDISPLAY(display);
+}
+
+static void destroy_barriers(EdgeBarriers *self)
+{
+  Display *xdisplay = get_xdisplay();
+  for (guint i = 0; i < self->edges->len; i++)
+  {
+    Edge *edge = &g_array_index(self->edges, Edge, i);
+    if (xdisplay != nullptr && edge->barrier != 0)
+    {
+      XFixesDestroyPointerBarrier(xdisplay, edge->barrier);
+    }
+  }
+  g_array_set_size(self->edges, 0);
+}
+
+// Creates a barrier along one side of the screen. Only motion towards the
+// neighbouring machine is blocked; the opposite direction passes freely.
+static gulong create_barrier(Display *xdisplay, gint side, double start,
+                             double end)
+{
+  Window root = DefaultRootWindow(xdisplay);
+  int width = DisplayWidth(xdisplay, DefaultScreen(xdisplay));
+  int height = DisplayHeight(xdisplay, DefaultScreen(xdisplay));
+
+  int from_x, from_y, to_x, to_y, directions;
+  switch (side)
+  {
+  case EDGE_SIDE_LEFT:
+    from_x = to_x = 0;
+    from_y = start * height;
+    to_y = end * height;
+    directions = BarrierPositiveX;
+    break;
+  case EDGE_SIDE_RIGHT:
+    from_x = to_x = width;
+    from_y = start * height;
+    to_y = end * height;
+    directions = BarrierNegativeX;
+    break;
+  case EDGE_SIDE_TOP:
+    from_y = to_y = 0;
+    from_x = start * width;
+    to_x = end * width;
+    directions = BarrierPositiveY;
+    break;
+  case EDGE_SIDE_BOTTOM:
+    from_y = to_y = height;
+    from_x = start * width;
+    to_x = end * width;
+    directions = BarrierNegativeY;
+    break;
+  default:
+    return 0;
+  }
+
+  return XFixesCreatePointerBarrier(xdisplay, root, from_x, from_y, to_x, to_y,
+                                    directions, 0, nullptr);
+}
+
+static void handle_barrier_event(EdgeBarriers *self, XIBarrierEvent *event)
+{
+  Edge *edge = nullptr;
+  for (guint i = 0; i < self->edges->len; i++)
+  {
+    if (g_array_index(self->edges, Edge, i).barrier == event->barrier)
+    {
+      edge = &g_array_index(self->edges, Edge, i);
+      break;
+    }
+  }
+  if (edge == nullptr)
+  {
+    return;
+  }
+
+  if (event->evtype == XI_BarrierLeave)
+  {
+    edge_filter_leave(&edge->filter);
+    return;
+  }
+
+  double velocity = 0;
+  if (!edge_filter_hit(&edge->filter, event->eventid, event->time, event->dx,
+                       event->dy, event->dtime, &velocity))
+  {
+    return;
+  }
+
+  if (focus_switcher_switch_to(self->switcher, edge->target, "edge"))
+  {
+    g_autoptr(FlValue) args = fl_value_new_map();
+    fl_value_set_string_take(args, "side",
+                             fl_value_new_int(edge->filter.side));
+    fl_value_set_string_take(args, "target", fl_value_new_int(edge->target));
+    fl_value_set_string_take(args, "x", fl_value_new_float(event->root_x));
+    fl_value_set_string_take(args, "y", fl_value_new_float(event->root_y));
+    fl_value_set_string_take(args, "velocity", fl_value_new_float(velocity));
+    fl_method_channel_invoke_method(self->channel, "crossed", args, nullptr,
+                                    nullptr, nullptr);
+  }
+}
+
+static GdkFilterReturn event_filter_cb(GdkXEvent *gdk_xevent, GdkEvent *event,
+                                       gpointer user_data)
+{
+  EdgeBarriers *self = EDGE_BARRIERS(user_data);
+  XEvent *xevent = static_cast<XEvent *>(gdk_xevent);
+  XGenericEventCookie *cookie = &xevent->xcookie;
+  if (xevent->type != GenericEvent || cookie->extension != self->xi_opcode ||
+      (cookie->evtype != XI_BarrierHit && cookie->evtype != XI_BarrierLeave))
+  {
+    return GDK_FILTER_CONTINUE;
+  }
+
+  // GDK normally fetches the cookie data before running filters.
+  gboolean fetched = FALSE;
+  if (cookie->data == nullptr)
+  {
+    fetched = XGetEventData(cookie->display, cookie);
+  }
+  if (cookie->data != nullptr)
+  {
+    handle_barrier_event(self, static_cast<XIBarrierEvent *>(cookie->data));
+  }
+  if (fetched)
+  {
+    XFreeEventData(cookie->display, cookie);
+  }
+  return GDK_FILTER_REMOVE;
+}
+
+// Subscribes to barrier events; requires XInput 2.3.
+static gboolean select_barrier_events(EdgeBarriers *self, Display *xdisplay)
+{
+  int event, error;
+  if (!XQueryExtension(xdisplay, "XInputExtension", &self->xi_opcode, &event,
+                       &error))
+  {
+    return FALSE;
+  }
+
+  int major = 2, minor = 3;
+  if (XIQueryVersion(xdisplay, &major, &minor) != Success ||
+      major * 10 + minor < 23)
+  {
+    return FALSE;
+  }
+
+  unsigned char mask_bits[XIMaskLen(XI_LASTEVENT)] = {};
+  XISetMask(mask_bits, XI_BarrierHit);
+  XISetMask(mask_bits, XI_BarrierLeave);
+
+  XIEventMask mask;
+  mask.deviceid = XIAllMasterDevices;
+  mask.mask_len = sizeof(mask_bits);
+  mask.mask = mask_bits;
+  XISelectEvents(xdisplay, DefaultRootWindow(xdisplay), &mask, 1);
+  return TRUE;
+}
+#endif
+
+static FlMethodResponse *set_edges(EdgeBarriers *self, FlValue *args)
+{
+#ifdef GDK_WINDOWING_X11
+  Display *xdisplay = get_xdisplay();
+  if (xdisplay == nullptr || self->xi_opcode == 0)
+  {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "unsupported", "Pointer barriers require X11 with XInput 2.3",
+        nullptr));
+  }
+
+  FlValue *edges = fl_value_lookup_string(args, "edges");
+  if (edges == nullptr || fl_value_get_type(edges) != FL_VALUE_TYPE_LIST)
+  {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad-args", "setEdges expects a list of edges", nullptr));
+  }
+
+  destroy_barriers(self);
+  for (size_t i = 0; i < fl_value_get_length(edges); i++)
+  {
+    FlValue *value = fl_value_get_list_value(edges, i);
+    FlValue *side = fl_value_lookup_string(value, "side");
+    FlValue *start = fl_value_lookup_string(value, "start");
+    FlValue *end = fl_value_lookup_string(value, "end");
+    FlValue *target = fl_value_lookup_string(value, "target");
+    if (side == nullptr || start == nullptr || end == nullptr ||
+        target == nullptr)
+    {
+      continue;
+    }
+
+    Edge edge = {};
+    edge.filter.side = fl_value_get_int(side);
+    edge.target = fl_value_get_int(target);
+    edge.barrier = create_barrier(xdisplay, edge.filter.side,
+                                  fl_value_get_float(start),
+                                  fl_value_get_float(end));
+    if (edge.barrier != 0)
+    {
+      g_array_append_val(self->edges, edge);
+    }
+  }
+  XFlush(xdisplay);
+  return FL_METHOD_RESPONSE(
+      fl_method_success_response_new(fl_value_new_int(self->edges->len)));
+#else
+  return FL_METHOD_RESPONSE(fl_method_error_response_new(
+      "unsupported", "Pointer barriers require X11 with XInput 2.3", nullptr));
+#endif
+}
+
+static void method_call_cb(FlMethodChannel *channel, FlMethodCall *method_call,
+                           gpointer user_data)
+{
+  EdgeBarriers *self = EDGE_BARRIERS(user_data);
+  const gchar *method = fl_method_call_get_name(method_call);
+  FlValue *args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "setEdges") == 0 &&
+      fl_value_get_type(args) == FL_VALUE_TYPE_MAP)
+  {
+    response = set_edges(self, args);
+  }
+  else if (strcmp(method, "clearEdges") == 0)
+  {
+#ifdef GDK_WINDOWING_X11
+    destroy_barriers(self);
+#endif
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+  }
+  else
+  {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error))
+  {
+    g_warning("Failed to respond to %s: %s", method, error->message);
+  }
+}
+
+// Implements GObject::dispose.
+static void edge_barriers_dispose(GObject *object)
+{
+  EdgeBarriers *self = EDGE_BARRIERS(object);
+
+#ifdef GDK_WINDOWING_X11
+  gdk_window_remove_filter(nullptr, event_filter_cb, self);
+  if (self->edges != nullptr)
+  {
+    destroy_barriers(self);
+  }
+#endif
+  g_clear_pointer(&self->edges, g_array_unref);
+
+  if (self->channel != nullptr)
+  {
+    fl_method_channel_set_method_call_handler(self->channel, nullptr, nullptr,
+                                              nullptr);
+  }
+  g_clear_object(&self->channel);
+  g_clear_object(&self->switcher);
+
+  G_OBJECT_CLASS(edge_barriers_parent_class)->dispose(object);
+}
+
+static void edge_barriers_class_init(EdgeBarriersClass *klass)
+{
+  G_OBJECT_CLASS(klass)->dispose = edge_barriers_dispose;
+}
+
+static void edge_barriers_init(EdgeBarriers *self)
+{
+  self->edges = g_array_new(FALSE, TRUE, sizeof(Edge));
+}
+
+EdgeBarriers *edge_barriers_new(FlBinaryMessenger *messenger,
+                                FocusSwitcher *switcher)
+{
+  EdgeBarriers *self =
+      EDGE_BARRIERS(g_object_new(edge_barriers_get_type(), nullptr));
+  self->switcher = FOCUS_SWITCHER(g_object_ref(switcher));
+
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  self->channel = fl_method_channel_new(messenger, "desk_switch/edge_barriers",
+                                        FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(self->channel, method_call_cb,
+                                            self, nullptr);
+
+#ifdef GDK_WINDOWING_X11
+  Display *xdisplay = get_xdisplay();
+  if (xdisplay != nullptr)
+  {
+    if (select_barrier_events(self, xdisplay))
+    {
+      gdk_window_add_filter(nullptr, event_filter_cb, self);
+    }
+    else
+    {
+      self->xi_opcode = 0;
+      g_warning("XInput 2.3 is unavailable; edge barriers are disabled");
+    }
+  }
+#endif
+
+  return self;
+}
@@ -0,0 +1,27 @@
+#ifndef FLUTTER_EDGE_BARRIERS_H_
+#define FLUTTER_EDGE_BARRIERS_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <gtk/gtk.h>
+
+#include "focus_switcher.h"
+
+G_DECLARE_FINAL_TYPE(EdgeBarriers, edge_barriers, EDGE, BARRIERS, GObject)
+
+/**
+ * edge_barriers_new:
+ * @messenger: the engine's binary messenger.
+ * @switcher: the #FocusSwitcher to drive when an edge is crossed.
+ *
+ * Creates XFixes pointer barriers on the screen edges that Dart marks as
+ * adjacent to a remote machine over the `desk_switch/edge_barriers` method
+ * channel. Edge hits arrive as XInput2 barrier events instead of being
+ * polled, and a crossing is only reported once the pointer has pushed
+ * against the edge hard enough to clear the #EdgeFilter hysteresis.
+ *
+ * Returns: a new #EdgeBarriers.
+ */
+EdgeBarriers* edge_barriers_new(FlBinaryMessenger* messenger,
+                                FocusSwitcher* switcher);
+
+#endif  // FLUTTER_EDGE_BARRIERS_H_
@@ -0,0 +1,68 @@
+#include "edge_filter.h"
+
+// Blocked motion, in pixels, that turns an edge hit into a crossing.
+static const double kCrossingPressure = 24.0;
+
+// Minimum speed towards the edge, in pixels per millisecond.
+static const double kCrossingVelocity = 0.15;
+
+// A pause this long between hits starts a new push.
+static const guint kPushTimeoutMs = 150;
+
+// Component of the blocked motion that points into the edge.
+static double push_towards(gint side, double dx, double dy)
+{
+  switch (side)
+  {
+  case EDGE_SIDE_LEFT:
+    return -dx;
+  case EDGE_SIDE_RIGHT:
+    return dx;
+  case EDGE_SIDE_TOP:
+    return -dy;
+  case EDGE_SIDE_BOTTOM:
+    return dy;
+  default:
+    return 0;
+  }
+}
+
+gboolean edge_filter_hit(EdgeFilter *filter, guint event_id, guint time,
+                         gdouble dx, gdouble dy, guint dtime,
+                         gdouble *velocity)
+{
+  // Each continuous push gets its own event id; anything else resets the
+  // accumulated pressure.
+  if (filter->event_id != event_id ||
+      time - filter->last_time > kPushTimeoutMs)
+  {
+    filter->event_id = event_id;
+    filter->pressure = 0;
+  }
+  filter->last_time = time;
+
+  double push = push_towards(filter->side, dx, dy);
+  double speed = dtime > 0 ? push / dtime : 0;
+  if (velocity != nullptr)
+  {
+    *velocity = speed;
+  }
+  if (push <= 0 || speed < kCrossingVelocity)
+  {
+    return FALSE;
+  }
+
+  filter->pressure += push;
+  if (filter->pressure < kCrossingPressure)
+  {
+    return FALSE;
+  }
+
+  filter->pressure = 0;
+  return TRUE;
+}
+
+void edge_filter_leave(EdgeFilter *filter)
+{
+  filter->pressure = 0;
+}
@@ -0,0 +1,70 @@
+#ifndef FLUTTER_EDGE_FILTER_H_
+#define FLUTTER_EDGE_FILTER_H_
+
+#include <glib.h>
+
+/**
+ * EdgeSide:
+ * @EDGE_SIDE_LEFT: the left side of the screen.
+ * @EDGE_SIDE_TOP: the top side of the screen.
+ * @EDGE_SIDE_RIGHT: the right side of the screen.
+ * @EDGE_SIDE_BOTTOM: the bottom side of the screen.
+ *
+ * Screen sides, in the order used by Dart.
+ */
+typedef enum
+{
+  EDGE_SIDE_LEFT,
+  EDGE_SIDE_TOP,
+  EDGE_SIDE_RIGHT,
+  EDGE_SIDE_BOTTOM,
+} EdgeSide;
+
+/**
+ * EdgeFilter:
+ * @side: the #EdgeSide the barrier sits on.
+ * @event_id: the barrier event id of the current push.
+ * @last_time: server time of the last hit, in milliseconds.
+ * @pressure: blocked motion accumulated by the current push.
+ *
+ * Velocity and hysteresis filter for the hits on one pointer barrier. Only
+ * a continuous, fast enough push into the edge turns into a crossing, so
+ * brushing past an edge never switches. Zero-initialise it apart from
+ * @side.
+ */
+typedef struct
+{
+  gint side;
+  guint event_id;
+  guint last_time;
+  gdouble pressure;
+} EdgeFilter;
+
+/**
+ * edge_filter_hit:
+ * @filter: an #EdgeFilter.
+ * @event_id: the barrier event id of the hit.
+ * @time: server time of the hit, in milliseconds.
+ * @dx: blocked horizontal motion, in pixels.
+ * @dy: blocked vertical motion, in pixels.
+ * @dtime: milliseconds since the previous motion event.
+ * @velocity: (out) (optional): speed towards the edge, in pixels per
+ *   millisecond.
+ *
+ * Feeds one barrier hit into the filter.
+ *
+ * Returns: %TRUE when the push has crossed the edge.
+ */
+gboolean edge_filter_hit(EdgeFilter* filter, guint event_id, guint time,
+                         gdouble dx, gdouble dy, guint dtime,
+                         gdouble* velocity);
+
+/**
+ * edge_filter_leave:
+ * @filter: an #EdgeFilter.
+ *
+ * Drops the current push once the pointer moves away from the barrier.
+ */
+void edge_filter_leave(EdgeFilter* filter);
+
+#endif  // FLUTTER_EDGE_FILTER_H_
@@ -0,0 +1,569 @@
+#include "focus_switcher.h"
+
+#include <cstring>
+
+#ifdef GDK_WINDOWING_X11
+#include <X11/XKBlib.h>
+#include <X11/Xlib.h>
+#include <X11/extensions/Xfixes.h>
+#include <gdk/gdkx.h>
+#endif
+
+// Modifier bits used by Dart when registering hotkeys.
+enum
+{
+  kModifierShift = 1 << 0,
+  kModifierControl = 1 << 1,
+  kModifierAlt = 1 << 2,
+  kModifierSuper = 1 << 3,
+};
+
+// Relative targets accepted by registerHotkey.
+enum
+{
+  kTargetNext = -1,
+  kTargetPrevious = -2,
+};
+
+enum
+{
+  kSignalSwitched,
+  kSignalCount,
+};
+
+static guint signals[kSignalCount];
+
+typedef struct
+{
+  gint id;
+  guint keycode;
+  guint modifiers;
+  gint target;
+  gboolean pressed;
+} Hotkey;
+
+struct _FocusSwitcher
+{
+  GObject parent_instance;
+  FlMethodChannel *channel;
+  GArray *hotkeys;
+  gint target_count;
+  gint active_target;
+
+  // Local pointer grab, held while any forwarder asks for it.
+  guint pointer_holds;
+  gboolean pointer_grabbed;
+  gulong grab_window;
+};
+
+G_DEFINE_TYPE(FocusSwitcher, focus_switcher, G_TYPE_OBJECT)
+
+#ifdef GDK_WINDOWING_X11
+// Lock modifiers that must not prevent a hotkey from matching.
+static const guint kIgnoredModifiers[] = {0, LockMask, Mod2Mask,
+                                          LockMask | Mod2Mask};
+static const guint kModifierMask = ShiftMask | ControlMask | Mod1Mask | Mod4Mask;
+
+static Display *get_xdisplay()
+{
+  GdkDisplay *display = gdk_display_get_default();
+  if (display == nullptr || !GDK_IS_X11_DISPLAY(display))
+  {
+    return nullptr;
+  }
+  return GDK_DISPLAY_XDISPLAY(display);
+}
+
+static guint to_x11_modifiers(gint64 modifiers)
+{
+  guint mask = 0;
+  if (modifiers & kModifierShift)
+    mask |= ShiftMask;
+  if (modifiers & kModifierControl)
+    mask |= ControlMask;
+  if (modifiers & kModifierAlt)
+    mask |= Mod1Mask;
+  if (modifiers & kModifierSuper)
+    mask |= Mod4Mask;
+  return mask;
+}
+
+// Grabs or releases a hotkey on the root window. Returns FALSE if another
+// client already holds the grab.
+static gboolean set_grab(const Hotkey *hotkey, gboolean grab)
+{
+  Display *xdisplay = get_xdisplay();
+  if (xdisplay == nullptr)
+  {
+    return FALSE;
+  }
+
+  GdkDisplay *display = gdk_display_get_default();
+  Window root = DefaultRootWindow(xdisplay);
+  gdk_x11_display_error_trap_push(display);
+  for (guint extra : kIgnoredModifiers)
+  {
+    if (grab)
+    {
+      XGrabKey(xdisplay, hotkey->keycode, hotkey->modifiers | extra, root,
+               False, GrabModeAsync, GrabModeAsync);
+    }
+    else
+    {
+      XUngrabKey(xdisplay, hotkey->keycode, hotkey->modifiers | extra, root);
+    }
+  }
+  return gdk_x11_display_error_trap_pop(display) == 0;
+}
+
+static gint resolve_target(FocusSwitcher *self, gint target)
+{
+  if (self->target_count <= 0)
+  {
+    return -1;
+  }
+  switch (target)
+  {
+  case kTargetNext:
+    return (self->active_target + 1) % self->target_count;
+  case kTargetPrevious:
+    return (self->active_target + self->target_count - 1) % self->target_count;
+  default:
+    return target;
+  }
+}
+
+// Handles grabbed key events straight from the X connection, before GTK or
+// Flutter see them, so a switch never waits for a Dart round trip.
+static GdkFilterReturn root_filter_cb(GdkXEvent *gdk_xevent, GdkEvent *event,
+                                      gpointer user_data)
+{
+  FocusSwitcher *self = FOCUS_SWITCHER(user_data);
+  XEvent *xevent = static_cast<XEvent *>(gdk_xevent);
+  if (xevent->type != KeyPress && xevent->type != KeyRelease)
+  {
+    return GDK_FILTER_CONTINUE;
+  }
+
+  // Modifiers may already be up when the key is released, so a release
+  // clears every hotkey on the key.
+  if (xevent->type == KeyRelease)
+  {
+    gboolean matched = FALSE;
+    for (guint i = 0; i < self->hotkeys->len; i++)
+    {
+      Hotkey *hotkey = &g_array_index(self->hotkeys, Hotkey, i);
+      if (hotkey->keycode == xevent->xkey.keycode)
+      {
+        hotkey->pressed = FALSE;
+        matched = TRUE;
+      }
+    }
+    return matched ? GDK_FILTER_REMOVE : GDK_FILTER_CONTINUE;
+  }
+
+  guint modifiers = xevent->xkey.state & kModifierMask;
+  for (guint i = 0; i < self->hotkeys->len; i++)
+  {
+    Hotkey *hotkey = &g_array_index(self->hotkeys, Hotkey, i);
+    if (hotkey->keycode != xevent->xkey.keycode ||
+        hotkey->modifiers != modifiers)
+    {
+      continue;
+    }
+
+    // Ignore auto-repeat so holding a relative hotkey does not cycle.
+    if (!hotkey->pressed)
+    {
+      hotkey->pressed = TRUE;
+      focus_switcher_switch_to(self, resolve_target(self, hotkey->target),
+                               "hotkey");
+    }
+    return GDK_FILTER_REMOVE;
+  }
+  return GDK_FILTER_CONTINUE;
+}
+
+// Confines the pointer to an invisible 1x1 window in the middle of the
+// screen and hides it. Raw XInput2 events keep reporting the device, while
+// local windows see no motion, clicks or wheel events.
+static void grab_local_pointer(FocusSwitcher *self)
+{
+  Display *xdisplay = get_xdisplay();
+  if (xdisplay == nullptr || self->pointer_grabbed)
+  {
+    return;
+  }
+
+  Window root = DefaultRootWindow(xdisplay);
+  if (self->grab_window == None)
+  {
+    int screen = DefaultScreen(xdisplay);
+    XSetWindowAttributes attributes = {};
+    attributes.override_redirect = True;
+    self->grab_window = XCreateWindow(
+        xdisplay, root, DisplayWidth(xdisplay, screen) / 2,
+        DisplayHeight(xdisplay, screen) / 2, 1, 1, 0, CopyFromParent,
+        InputOnly, CopyFromParent, CWOverrideRedirect, &attributes);
+  }
+  // Override-redirect maps at once, so the window is viewable for the grab.
+  XMapRaised(xdisplay, self->grab_window);
+
+  int status = XGrabPointer(
+      xdisplay, self->grab_window, False,
+      ButtonPressMask | ButtonReleaseMask | PointerMotionMask, GrabModeAsync,
+      GrabModeAsync, self->grab_window, None, CurrentTime);
+  if (status == GrabSuccess)
+  {
+    XFixesHideCursor(xdisplay, root);
+    self->pointer_grabbed = TRUE;
+  }
+  else
+  {
+    XUnmapWindow(xdisplay, self->grab_window);
+    g_warning("Failed to grab the local pointer (status %d)", status);
+  }
+  XFlush(xdisplay);
+}
+
+static void ungrab_local_pointer(FocusSwitcher *self)
+{
+  Display *xdisplay = get_xdisplay();
+  if (xdisplay == nullptr || !self->pointer_grabbed)
+  {
+    return;
+  }
+  self->pointer_grabbed = FALSE;
+  XUngrabPointer(xdisplay, CurrentTime);
+  XFixesShowCursor(xdisplay, DefaultRootWindow(xdisplay));
+  XUnmapWindow(xdisplay, self->grab_window);
+  XFlush(xdisplay);
+}
+
+static Hotkey *find_hotkey(FocusSwitcher *self, gint id)
+{
+  for (guint i = 0; i < self->hotkeys->len; i++)
+  {
+    Hotkey *hotkey = &g_array_index(self->hotkeys, Hotkey, i);
+    if (hotkey->id == id)
+    {
+      return hotkey;
+    }
+  }
+  return nullptr;
+}
+#endif
+
+static FlMethodResponse *register_hotkey(FocusSwitcher *self, FlValue *args)
+{
+  FlValue *id = fl_value_lookup_string(args, "id");
+  FlValue *key = fl_value_lookup_string(args, "key");
+  FlValue *modifiers = fl_value_lookup_string(args, "modifiers");
+  FlValue *target = fl_value_lookup_string(args, "target");
+  if (id == nullptr || fl_value_get_type(id) != FL_VALUE_TYPE_INT ||
+      key == nullptr || fl_value_get_type(key) != FL_VALUE_TYPE_STRING ||
+      modifiers == nullptr ||
+      fl_value_get_type(modifiers) != FL_VALUE_TYPE_INT ||
+      target == nullptr || fl_value_get_type(target) != FL_VALUE_TYPE_INT)
+  {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad-args", "registerHotkey expects id, key, modifiers, target",
+        nullptr));
+  }
+
+#ifdef GDK_WINDOWING_X11
+  Display *xdisplay = get_xdisplay();
+  if (xdisplay == nullptr)
+  {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "unsupported", "Global hotkeys require an X11 display", nullptr));
+  }
+
+  KeySym keysym = XStringToKeysym(fl_value_get_string(key));
+  KeyCode keycode = keysym == NoSymbol ? 0 : XKeysymToKeycode(xdisplay, keysym);
+  if (keycode == 0)
+  {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad-key", "Unknown key name", key));
+  }
+
+  Hotkey hotkey = {};
+  hotkey.id = fl_value_get_int(id);
+  hotkey.keycode = keycode;
+  hotkey.modifiers = to_x11_modifiers(fl_value_get_int(modifiers));
+  hotkey.target = fl_value_get_int(target);
+
+  // Registering an id again replaces its hotkey. The old grab goes first
+  // in case both share a key, and comes back if the new one fails.
+  Hotkey *existing = find_hotkey(self, hotkey.id);
+  if (existing != nullptr)
+  {
+    set_grab(existing, FALSE);
+  }
+
+  if (!set_grab(&hotkey, TRUE))
+  {
+    set_grab(&hotkey, FALSE);
+    if (existing != nullptr)
+    {
+      set_grab(existing, TRUE);
+    }
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "grab-failed", "Hotkey is already grabbed by another client",
+        nullptr));
+  }
+
+  if (existing != nullptr)
+    *existing = hotkey;
+  else
+    g_array_append_val(self->hotkeys, hotkey);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+#else
+  return FL_METHOD_RESPONSE(fl_method_error_response_new(
+      "unsupported", "Global hotkeys require an X11 display", nullptr));
+#endif
+}
+
+static void remove_hotkey(FocusSwitcher *self, guint index)
+{
+#ifdef GDK_WINDOWING_X11
+  set_grab(&g_array_index(self->hotkeys, Hotkey, index), FALSE);
+#endif
+  g_array_remove_index_fast(self->hotkeys, index);
+}
+
+static FlMethodResponse *unregister_hotkey(FocusSwitcher *self, FlValue *args)
+{
+  FlValue *id = fl_value_lookup_string(args, "id");
+  if (id == nullptr || fl_value_get_type(id) != FL_VALUE_TYPE_INT)
+  {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad-args", "unregisterHotkey expects id", nullptr));
+  }
+  for (guint i = 0; i < self->hotkeys->len; i++)
+  {
+    if (g_array_index(self->hotkeys, Hotkey, i).id == fl_value_get_int(id))
+    {
+      remove_hotkey(self, i);
+      break;
+    }
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+// Dart owns the peer list; keep the native view of it in sync without
+// echoing a switch back.
+static FlMethodResponse *set_targets(FocusSwitcher *self, FlValue *args)
+{
+  FlValue *count = fl_value_lookup_string(args, "count");
+  FlValue *active = fl_value_lookup_string(args, "active");
+  if (count == nullptr || fl_value_get_type(count) != FL_VALUE_TYPE_INT ||
+      (active != nullptr && fl_value_get_type(active) != FL_VALUE_TYPE_INT))
+  {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad-args", "setTargets expects count and an optional active",
+        nullptr));
+  }
+
+  gint64 new_count = fl_value_get_int(count);
+  gint64 new_active =
+      active != nullptr ? fl_value_get_int(active) : self->active_target;
+  if (new_count < 1 || new_active < 0 || new_active >= new_count)
+  {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad-args", "Active target is out of range", nullptr));
+  }
+
+  gint previous = self->active_target;
+  self->target_count = new_count;
+  self->active_target = new_active;
+  if (new_active != previous)
+  {
+    g_signal_emit(self, signals[kSignalSwitched], 0, self->active_target,
+                  previous);
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+static void method_call_cb(FlMethodChannel *channel, FlMethodCall *method_call,
+                           gpointer user_data)
+{
+  FocusSwitcher *self = FOCUS_SWITCHER(user_data);
+  const gchar *method = fl_method_call_get_name(method_call);
+  FlValue *args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (fl_value_get_type(args) != FL_VALUE_TYPE_MAP)
+  {
+    response = FL_METHOD_RESPONSE(
+        fl_method_error_response_new("bad-args", "Expected a map", nullptr));
+  }
+  else if (strcmp(method, "registerHotkey") == 0)
+  {
+    response = register_hotkey(self, args);
+  }
+  else if (strcmp(method, "unregisterHotkey") == 0)
+  {
+    response = unregister_hotkey(self, args);
+  }
+  else if (strcmp(method, "setTargets") == 0)
+  {
+    response = set_targets(self, args);
+  }
+  else
+  {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error))
+  {
+    g_warning("Failed to respond to %s: %s", method, error->message);
+  }
+}
+
+gboolean focus_switcher_switch_to(FocusSwitcher *self, gint target,
+                                  const gchar *source)
+{
+  g_return_val_if_fail(FOCUS_IS_SWITCHER(self), FALSE);
+
+  if (target < 0 || target >= self->target_count ||
+      target == self->active_target)
+  {
+    return FALSE;
+  }
+
+  gint previous = self->active_target;
+  self->active_target = target;
+
+  // Start forwarding first; the UI update can wait.
+  g_signal_emit(self, signals[kSignalSwitched], 0, target, previous);
+
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "target", fl_value_new_int(target));
+  fl_value_set_string_take(args, "previous", fl_value_new_int(previous));
+  fl_value_set_string_take(args, "source", fl_value_new_string(source));
+  fl_method_channel_invoke_method(self->channel, "switched", args, nullptr,
+                                  nullptr, nullptr);
+  return TRUE;
+}
+
+gint focus_switcher_get_active_target(FocusSwitcher *self)
+{
+  g_return_val_if_fail(FOCUS_IS_SWITCHER(self), 0);
+  return self->active_target;
+}
+
+gint focus_switcher_get_target_count(FocusSwitcher *self)
+{
+  g_return_val_if_fail(FOCUS_IS_SWITCHER(self), 1);
+  return self->target_count;
+}
+
+void focus_switcher_restore(FocusSwitcher *self, gint count, gint active)
+{
+  g_return_if_fail(FOCUS_IS_SWITCHER(self));
+  if (count < 1 || active < 0 || active >= count)
+  {
+    return;
+  }
+  self->target_count = count;
+  self->active_target = active;
+}
+
+void focus_switcher_grab_pointer(FocusSwitcher *self)
+{
+  g_return_if_fail(FOCUS_IS_SWITCHER(self));
+  if (self->pointer_holds++ == 0)
+  {
+#ifdef GDK_WINDOWING_X11
+    grab_local_pointer(self);
+#endif
+  }
+}
+
+void focus_switcher_ungrab_pointer(FocusSwitcher *self)
+{
+  g_return_if_fail(FOCUS_IS_SWITCHER(self));
+  g_return_if_fail(self->pointer_holds > 0);
+  if (--self->pointer_holds == 0)
+  {
+#ifdef GDK_WINDOWING_X11
+    ungrab_local_pointer(self);
+#endif
+  }
+}
+
+// Implements GObject::dispose.
+static void focus_switcher_dispose(GObject *object)
+{
+  FocusSwitcher *self = FOCUS_SWITCHER(object);
+
+#ifdef GDK_WINDOWING_X11
+  GdkWindow *root = gdk_get_default_root_window();
+  if (root != nullptr)
+  {
+    gdk_window_remove_filter(root, root_filter_cb, self);
+  }
+  ungrab_local_pointer(self);
+  Display *xdisplay = get_xdisplay();
+  if (xdisplay != nullptr && self->grab_window != None)
+  {
+    XDestroyWindow(xdisplay, self->grab_window);
+    self->grab_window = None;
+  }
+#endif
+  while (self->hotkeys != nullptr && self->hotkeys->len > 0)
+  {
+    remove_hotkey(self, self->hotkeys->len - 1);
+  }
+  g_clear_pointer(&self->hotkeys, g_array_unref);
+
+  if (self->channel != nullptr)
+  {
+    fl_method_channel_set_method_call_handler(self->channel, nullptr, nullptr,
+                                              nullptr);
+  }
+  g_clear_object(&self->channel);
+
+  G_OBJECT_CLASS(focus_switcher_parent_class)->dispose(object);
+}
+
+static void focus_switcher_class_init(FocusSwitcherClass *klass)
+{
+  G_OBJECT_CLASS(klass)->dispose = focus_switcher_dispose;
+
+  signals[kSignalSwitched] = g_signal_new(
+      "switched", focus_switcher_get_type(), G_SIGNAL_RUN_LAST, 0, nullptr,
+      nullptr, nullptr, G_TYPE_NONE, 2, G_TYPE_INT, G_TYPE_INT);
+}
+
+static void focus_switcher_init(FocusSwitcher *self)
+{
+  self->hotkeys = g_array_new(FALSE, TRUE, sizeof(Hotkey));
+  self->target_count = 1;
+}
+
+FocusSwitcher *focus_switcher_new(FlBinaryMessenger *messenger)
+{
+  FocusSwitcher *self =
+      FOCUS_SWITCHER(g_object_new(focus_switcher_get_type(), nullptr));
+
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  self->channel = fl_method_channel_new(messenger, "desk_switch/focus_switcher",
+                                        FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(self->channel, method_call_cb,
+                                            self, nullptr);
+
+#ifdef GDK_WINDOWING_X11
+  Display *xdisplay = get_xdisplay();
+  if (xdisplay != nullptr)
+  {
+    // Report held keys as a single press so the pressed flag stays accurate.
+    XkbSetDetectableAutoRepeat(xdisplay, True, nullptr);
+    gdk_window_add_filter(gdk_get_default_root_window(), root_filter_cb, self);
+  }
+#endif
+
+  return self;
+}
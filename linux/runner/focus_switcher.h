@@ -0,0 +1,86 @@
+#ifndef FLUTTER_FOCUS_SWITCHER_H_
+#define FLUTTER_FOCUS_SWITCHER_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <gtk/gtk.h>
+
+G_DECLARE_FINAL_TYPE(FocusSwitcher, focus_switcher, FOCUS, SWITCHER, GObject)
+
+/**
+ * focus_switcher_new:
+ * @messenger: the engine's binary messenger.
+ *
+ * Creates the native focus switcher. Switch hotkeys are grabbed globally on
+ * the X11 root window and registered from Dart over the
+ * `desk_switch/focus_switcher` method channel.
+ *
+ * Every switch emits the `switched` signal with the new and the previous
+ * target, in the same main loop iteration as the event that caused it and
+ * before Dart is notified. A change of the active target through
+ * `setTargets` emits it too. Modules that forward input connect to it.
+ *
+ * Returns: a new #FocusSwitcher.
+ */
+FocusSwitcher* focus_switcher_new(FlBinaryMessenger* messenger);
+
+/**
+ * focus_switcher_switch_to:
+ * @switcher: a #FocusSwitcher.
+ * @target: the machine to focus, 0 being the local machine.
+ * @source: what triggered the switch, e.g. "hotkey".
+ *
+ * Switches focus natively, then notifies Dart with `switched`.
+ *
+ * Returns: %TRUE if the active target changed.
+ */
+gboolean focus_switcher_switch_to(FocusSwitcher* switcher, gint target,
+                                  const gchar* source);
+
+/**
+ * focus_switcher_get_active_target:
+ * @switcher: a #FocusSwitcher.
+ *
+ * Returns: the machine that currently has focus.
+ */
+gint focus_switcher_get_active_target(FocusSwitcher* switcher);
+
+/**
+ * focus_switcher_get_target_count:
+ * @switcher: a #FocusSwitcher.
+ *
+ * Returns: the number of machines that can take focus.
+ */
+gint focus_switcher_get_target_count(FocusSwitcher* switcher);
+
+/**
+ * focus_switcher_grab_pointer:
+ * @switcher: a #FocusSwitcher.
+ *
+ * Takes a hold on the local pointer. While any hold is taken, the pointer
+ * is hidden and confined to an invisible window, so local windows see no
+ * motion, clicks or wheel events; XInput2 raw events still report the
+ * devices. Each call is balanced by focus_switcher_ungrab_pointer().
+ */
+void focus_switcher_grab_pointer(FocusSwitcher* switcher);
+
+/**
+ * focus_switcher_ungrab_pointer:
+ * @switcher: a #FocusSwitcher.
+ *
+ * Releases a hold taken with focus_switcher_grab_pointer(). The pointer is
+ * given back once the last hold is released.
+ */
+void focus_switcher_ungrab_pointer(FocusSwitcher* switcher);
+
+/**
+ * focus_switcher_restore:
+ * @switcher: a #FocusSwitcher.
+ * @count: number of machines that can take focus.
+ * @active: the machine that had focus before a restart.
+ *
+ * Restores the switcher's targets from a saved session without emitting
+ * `switched` or notifying Dart.
+ */
+void focus_switcher_restore(FocusSwitcher* switcher, gint count, gint active);
+
+#endif  // FLUTTER_FOCUS_SWITCHER_H_
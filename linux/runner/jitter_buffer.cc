@@ -0,0 +1,208 @@
+#include "jitter_buffer.h"
+
+#include <cmath>
+
+// Slots in the ring; must exceed max_depth plus the reorder window.
+static const guint kCapacity = 128;
+
+// Frames played without an underrun before the target may shrink.
+static const guint kShrinkAfterFrames = 500;
+
+struct _JitterBuffer
+{
+  GMutex mutex;
+  guint frame_ms;
+  guint min_depth;
+  guint max_depth;
+
+  GBytes *slots[kCapacity];
+  guint32 sequences[kCapacity];
+
+  // Playout position: the sequence number to pop next.
+  guint32 next_sequence;
+  gboolean started;
+  gboolean prebuffering;
+  guint target;
+  guint stable_frames;
+
+  // RFC 3550 style jitter estimate.
+  gboolean have_transit;
+  gint64 last_transit_us;
+  gdouble jitter_ms;
+
+  guint64 underruns;
+  guint64 late;
+  guint64 lost;
+};
+
+static guint depth_locked(JitterBuffer *self)
+{
+  guint depth = 0;
+  for (guint i = 0; i < kCapacity; i++)
+  {
+    if (self->slots[i] != nullptr)
+      depth++;
+  }
+  return depth;
+}
+
+// Frames of buffering needed to ride out the current jitter.
+static guint jitter_target(JitterBuffer *self)
+{
+  guint frames = static_cast<guint>(
+      std::ceil(2.0 * self->jitter_ms / self->frame_ms)) + 1;
+  return CLAMP(frames, self->min_depth, self->max_depth);
+}
+
+static void clear_slot(JitterBuffer *self, guint index)
+{
+  g_clear_pointer(&self->slots[index], g_bytes_unref);
+}
+
+JitterBuffer *jitter_buffer_new(guint frame_ms, guint min_depth,
+                                guint max_depth)
+{
+  JitterBuffer *self = g_new0(JitterBuffer, 1);
+  g_mutex_init(&self->mutex);
+  self->frame_ms = frame_ms;
+  self->min_depth = MAX(min_depth, 1u);
+  self->max_depth = CLAMP(max_depth, self->min_depth, kCapacity / 2);
+  self->target = self->min_depth;
+  self->prebuffering = TRUE;
+  return self;
+}
+
+void jitter_buffer_free(JitterBuffer *self)
+{
+  if (self == nullptr)
+    return;
+  for (guint i = 0; i < kCapacity; i++)
+    clear_slot(self, i);
+  g_mutex_clear(&self->mutex);
+  g_free(self);
+}
+
+void jitter_buffer_push(JitterBuffer *self, guint32 sequence, GBytes *payload,
+                        gint64 arrival_us)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->mutex);
+
+  // Transit time relative to the sender's clock, which ticks one frame per
+  // sequence number; only its variation matters.
+  gint64 transit_us =
+      arrival_us - static_cast<gint64>(sequence) * self->frame_ms * 1000;
+  if (self->have_transit)
+  {
+    gdouble delta_ms = std::fabs(transit_us - self->last_transit_us) / 1000.0;
+    self->jitter_ms += (delta_ms - self->jitter_ms) / 16.0;
+  }
+  self->have_transit = TRUE;
+  self->last_transit_us = transit_us;
+
+  if (!self->started)
+  {
+    self->next_sequence = sequence;
+    self->started = TRUE;
+  }
+
+  // Behind the playout position: too late to be useful.
+  gint32 ahead = static_cast<gint32>(sequence - self->next_sequence);
+  if (ahead < 0)
+  {
+    self->late++;
+    return;
+  }
+  if (static_cast<guint>(ahead) >= kCapacity)
+  {
+    // The sender jumped far ahead (e.g. restarted); resynchronise.
+    for (guint i = 0; i < kCapacity; i++)
+      clear_slot(self, i);
+    self->next_sequence = sequence;
+    self->prebuffering = TRUE;
+  }
+
+  guint index = sequence % kCapacity;
+  clear_slot(self, index);
+  self->slots[index] = g_bytes_ref(payload);
+  self->sequences[index] = sequence;
+
+  // Grow straight away when jitter rises; shrinking waits in pop().
+  self->target = MAX(self->target, jitter_target(self));
+}
+
+JitterBufferStatus jitter_buffer_pop(JitterBuffer *self, GBytes **payload)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->mutex);
+  *payload = nullptr;
+
+  guint depth = depth_locked(self);
+  if (self->prebuffering)
+  {
+    if (depth < self->target)
+      return JITTER_BUFFER_EMPTY;
+    self->prebuffering = FALSE;
+  }
+
+  if (depth == 0)
+  {
+    // Ran dry: buffer deeper and refill before playing again.
+    self->underruns++;
+    self->stable_frames = 0;
+    self->target = MIN(self->target + 1, self->max_depth);
+    self->prebuffering = TRUE;
+    return JITTER_BUFFER_EMPTY;
+  }
+
+  // Stable for a while and holding more than needed: skip one frame to
+  // cut latency.
+  if (++self->stable_frames >= kShrinkAfterFrames)
+  {
+    self->stable_frames = 0;
+    guint wanted = jitter_target(self);
+    if (self->target > wanted)
+      self->target--;
+    if (depth > self->target)
+    {
+      clear_slot(self, self->next_sequence % kCapacity);
+      self->next_sequence++;
+    }
+  }
+
+  guint index = self->next_sequence % kCapacity;
+  self->next_sequence++;
+  if (self->slots[index] != nullptr &&
+      self->sequences[index] == self->next_sequence - 1)
+  {
+    *payload = self->slots[index];
+    self->slots[index] = nullptr;
+    return JITTER_BUFFER_FRAME;
+  }
+
+  clear_slot(self, index);
+  self->lost++;
+  return JITTER_BUFFER_LOST;
+}
+
+void jitter_buffer_reset(JitterBuffer *self)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->mutex);
+  for (guint i = 0; i < kCapacity; i++)
+    clear_slot(self, i);
+  self->started = FALSE;
+  self->prebuffering = TRUE;
+  self->have_transit = FALSE;
+  self->jitter_ms = 0;
+  self->target = self->min_depth;
+  self->stable_frames = 0;
+}
+
+void jitter_buffer_get_stats(JitterBuffer *self, JitterBufferStats *stats)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->mutex);
+  stats->depth = depth_locked(self);
+  stats->target = self->target;
+  stats->jitter_ms = self->jitter_ms;
+  stats->underruns = self->underruns;
+  stats->late = self->late;
+  stats->lost = self->lost;
+}
@@ -0,0 +1,106 @@
+#ifndef FLUTTER_JITTER_BUFFER_H_
+#define FLUTTER_JITTER_BUFFER_H_
+
+#include <glib.h>
+
+/**
+ * JitterBuffer:
+ *
+ * Adaptive playout buffer for fixed-duration audio frames.
+ *
+ * Packets are pushed from the network side in any order and popped by the
+ * playback thread once per frame. The target depth follows the measured
+ * inter-arrival jitter: it grows immediately on an underrun and shrinks one
+ * frame at a time after a stable period, trading latency against
+ * dropouts. All functions are thread-safe.
+ */
+typedef struct _JitterBuffer JitterBuffer;
+
+/**
+ * JitterBufferStatus:
+ * @JITTER_BUFFER_FRAME: a frame was returned.
+ * @JITTER_BUFFER_LOST: the next frame is missing; conceal it.
+ * @JITTER_BUFFER_EMPTY: nothing to play; output silence.
+ */
+typedef enum
+{
+  JITTER_BUFFER_FRAME,
+  JITTER_BUFFER_LOST,
+  JITTER_BUFFER_EMPTY,
+} JitterBufferStatus;
+
+/**
+ * JitterBufferStats:
+ * @depth: frames currently buffered.
+ * @target: frames the buffer aims to hold.
+ * @jitter_ms: smoothed inter-arrival jitter.
+ * @underruns: times playback ran dry.
+ * @late: packets dropped for arriving after their playout time.
+ * @lost: frames concealed because they never arrived.
+ */
+typedef struct
+{
+  guint depth;
+  guint target;
+  gdouble jitter_ms;
+  guint64 underruns;
+  guint64 late;
+  guint64 lost;
+} JitterBufferStats;
+
+/**
+ * jitter_buffer_new:
+ * @frame_ms: duration of one frame.
+ * @min_depth: smallest target depth, in frames.
+ * @max_depth: largest target depth, in frames.
+ *
+ * Returns: (transfer full): a new #JitterBuffer.
+ */
+JitterBuffer* jitter_buffer_new(guint frame_ms, guint min_depth,
+                                guint max_depth);
+
+/**
+ * jitter_buffer_free:
+ * @buffer: a #JitterBuffer.
+ */
+void jitter_buffer_free(JitterBuffer* buffer);
+
+/**
+ * jitter_buffer_push:
+ * @buffer: a #JitterBuffer.
+ * @sequence: the sender's frame counter.
+ * @payload: (transfer none): the encoded frame.
+ * @arrival_us: monotonic arrival time.
+ */
+void jitter_buffer_push(JitterBuffer* buffer, guint32 sequence,
+                        GBytes* payload, gint64 arrival_us);
+
+/**
+ * jitter_buffer_pop:
+ * @buffer: a #JitterBuffer.
+ * @payload: (out) (transfer full) (nullable): the frame to decode.
+ *
+ * Takes the next frame in playout order.
+ *
+ * Returns: what to play for this frame period.
+ */
+JitterBufferStatus jitter_buffer_pop(JitterBuffer* buffer, GBytes** payload);
+
+/**
+ * jitter_buffer_reset:
+ * @buffer: a #JitterBuffer.
+ *
+ * Drops all frames, e.g. when the sender changes.
+ */
+void jitter_buffer_reset(JitterBuffer* buffer);
+
+/**
+ * jitter_buffer_get_stats:
+ * @buffer: a #JitterBuffer.
+ * @stats: (out): the current statistics.
+ */
+void jitter_buffer_get_stats(JitterBuffer* buffer, JitterBufferStats* stats);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(JitterBuffer, jitter_buffer_free)
+
+#endif  // FLUTTER_JITTER_BUFFER_H_
@@ -6,15 +6,41 @@
 #endif
 
 #include "flutter/generated_plugin_registrant.h"
+#include "audio_forwarder.h"
+#include "edge_barriers.h"
+#include "focus_switcher.h"
+#include "pointer_forwarder.h"
+#include "scroll_forwarder.h"
+#include "session_snapshot.h"
 
 struct _MyApplication
 {
   GtkApplication parent_instance;
   char **dart_entrypoint_arguments;
+  FocusSwitcher *focus_switcher;
+  EdgeBarriers *edge_barriers;
+  AudioForwarder *audio_forwarder;
+  PointerForwarder *pointer_forwarder;
+  ScrollForwarder *scroll_forwarder;
+  SessionSnapshot *session_snapshot;
 };
 
 G_DEFINE_TYPE(MyApplication, my_application, GTK_TYPE_APPLICATION)
 
+// Closing the window is the user quitting, so the next run starts a new
+// session. Any other exit, e.g. an updater restarting the app, keeps the
+// snapshot for the next run to resume.
+static gboolean window_delete_cb(GtkWidget *window, GdkEvent *event,
+                                 gpointer user_data)
+{
+  MyApplication *self = MY_APPLICATION(user_data);
+  if (self->session_snapshot != nullptr)
+  {
+    session_snapshot_discard(self->session_snapshot);
+  }
+  return FALSE;
+}
+
 // Implements GApplication::activate.
 static void my_application_activate(GApplication *application)
 {
@@ -66,6 +92,23 @@ static void my_application_activate(GApplication *application)
 
   fl_register_plugins(FL_PLUGIN_REGISTRY(view));
 
+  FlBinaryMessenger *messenger =
+      fl_engine_get_binary_messenger(fl_view_get_engine(view));
+  self->focus_switcher = focus_switcher_new(messenger);
+  self->edge_barriers = edge_barriers_new(messenger, self->focus_switcher);
+  self->audio_forwarder = audio_forwarder_new(messenger);
+  self->pointer_forwarder =
+      pointer_forwarder_new(messenger, self->focus_switcher);
+  self->scroll_forwarder =
+      scroll_forwarder_new(messenger, self->focus_switcher);
+
+  // Restores the previous run's focus before Dart starts, then records
+  // every switch from here on.
+  self->session_snapshot =
+      session_snapshot_new(messenger, self->focus_switcher);
+  g_signal_connect(window, "delete-event", G_CALLBACK(window_delete_cb),
+                   self);
+
   gtk_widget_grab_focus(GTK_WIDGET(view));
 }
 
@@ -115,6 +158,12 @@ static void my_application_dispose(GObject *object)
 {
   MyApplication *self = MY_APPLICATION(object);
   g_clear_pointer(&self->dart_entrypoint_arguments, g_strfreev);
+  g_clear_object(&self->session_snapshot);
+  g_clear_object(&self->scroll_forwarder);
+  g_clear_object(&self->pointer_forwarder);
+  g_clear_object(&self->audio_forwarder);
+  g_clear_object(&self->edge_barriers);
+  g_clear_object(&self->focus_switcher);
   G_OBJECT_CLASS(my_application_parent_class)->dispose(object);
 }
 
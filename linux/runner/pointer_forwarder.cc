@@ -0,0 +1,459 @@
+#include "pointer_forwarder.h"
+
+#include <cstring>
+
+#ifdef GDK_WINDOWING_X11
+#include <X11/Xlib.h>
+#include <X11/extensions/XInput2.h>
+#include <X11/extensions/XTest.h>
+#include <gdk/gdkx.h>
+#endif
+
+// Capture frame; motion is summed over this window before it is sent.
+static const guint kFrameMs = 4;
+
+struct _PointerForwarder
+{
+  GObject parent_instance;
+  FlMethodChannel *channel;
+  FocusSwitcher *switcher;
+
+  // Capture side.
+  gint xi_opcode;
+  gboolean capturing;
+  // Whether this module holds the switcher's local pointer grab.
+  gboolean holding_grab;
+  // Source device id to whether its X and Y valuators are relative.
+  GHashTable *relative_devices;
+  double pending_x;
+  double pending_y;
+  guint flush_source;
+
+  // Injection side.
+  gboolean xtest;
+};
+
+G_DEFINE_TYPE(PointerForwarder, pointer_forwarder, G_TYPE_OBJECT)
+
+static gboolean flush_cb(gpointer user_data)
+{
+  PointerForwarder *self = POINTER_FORWARDER(user_data);
+  self->flush_source = 0;
+
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "dx", fl_value_new_float(self->pending_x));
+  fl_value_set_string_take(args, "dy", fl_value_new_float(self->pending_y));
+  self->pending_x = 0;
+  self->pending_y = 0;
+  fl_method_channel_invoke_method(self->channel, "motion", args, nullptr,
+                                  nullptr, nullptr);
+  return G_SOURCE_REMOVE;
+}
+
+// Keeps the local pointer still and out of local windows while its motion
+// goes to a remote machine.
+static void update_grab(PointerForwarder *self)
+{
+  gboolean wanted = self->capturing &&
+                    focus_switcher_get_active_target(self->switcher) != 0;
+  if (wanted == self->holding_grab)
+  {
+    return;
+  }
+  self->holding_grab = wanted;
+  if (wanted)
+    focus_switcher_grab_pointer(self->switcher);
+  else
+    focus_switcher_ungrab_pointer(self->switcher);
+}
+
+static void switched_cb(FocusSwitcher *switcher, gint target, gint previous,
+                        gpointer user_data)
+{
+  update_grab(POINTER_FORWARDER(user_data));
+}
+
+static void reset_capture(PointerForwarder *self)
+{
+  if (self->flush_source != 0)
+  {
+    g_source_remove(self->flush_source);
+    self->flush_source = 0;
+  }
+  self->pending_x = 0;
+  self->pending_y = 0;
+}
+
+#ifdef GDK_WINDOWING_X11
+static Display *get_xdisplay()
+{
+  GdkDisplay *display = gdk_display_get_default();
+  if (display == nullptr || !GDK_IS_X11_DISPLAY(display))
+  {
+    return nullptr;
+  }
+  return GDK_DISPLAY_XDISPLAY(display);
+}
+
+// Tablets and touchscreens report absolute valuators, which cannot be
+// summed into a movement; only relative devices drive the remote pointer.
+static gboolean is_relative(PointerForwarder *self, Display *xdisplay,
+                            gint deviceid)
+{
+  gpointer cached;
+  if (g_hash_table_lookup_extended(self->relative_devices,
+                                   GINT_TO_POINTER(deviceid), nullptr,
+                                   &cached))
+  {
+    return GPOINTER_TO_INT(cached);
+  }
+
+  gboolean relative = FALSE;
+  int count = 0;
+  XIDeviceInfo *devices = XIQueryDevice(xdisplay, deviceid, &count);
+  for (int i = 0; i < count; i++)
+  {
+    for (int j = 0; j < devices[i].num_classes; j++)
+    {
+      if (devices[i].classes[j]->type != XIValuatorClass)
+      {
+        continue;
+      }
+      XIValuatorClassInfo *valuator =
+          reinterpret_cast<XIValuatorClassInfo *>(devices[i].classes[j]);
+      if (valuator->number == 0)
+      {
+        relative = valuator->mode == XIModeRelative;
+      }
+    }
+  }
+  if (devices != nullptr)
+  {
+    XIFreeDeviceInfo(devices);
+  }
+
+  g_hash_table_insert(self->relative_devices, GINT_TO_POINTER(deviceid),
+                      GINT_TO_POINTER(relative));
+  return relative;
+}
+
+// Returns whether the event was meant for this module.
+static gboolean handle_raw_event(PointerForwarder *self, Display *xdisplay,
+                                 XIRawEvent *event)
+{
+  // The slave's copy of each event belongs to the scroll forwarder.
+  if (event->deviceid == event->sourceid)
+  {
+    return FALSE;
+  }
+
+  // The pointer stays local while this machine has focus.
+  if (focus_switcher_get_active_target(self->switcher) == 0)
+  {
+    reset_capture(self);
+    return TRUE;
+  }
+  if (!is_relative(self, xdisplay, event->sourceid))
+  {
+    return TRUE;
+  }
+
+  // Accelerated values, so the remote pointer moves as the local one would.
+  const double *values = event->valuators.values;
+  gboolean moved = FALSE;
+  for (int number = 0; number < event->valuators.mask_len * 8 && number < 2;
+       number++)
+  {
+    if (!XIMaskIsSet(event->valuators.mask, number))
+    {
+      continue;
+    }
+    if (number == 0)
+      self->pending_x += *values++;
+    else
+      self->pending_y += *values++;
+    moved = TRUE;
+  }
+
+  if (moved && self->flush_source == 0)
+  {
+    self->flush_source = g_timeout_add(kFrameMs, flush_cb, self);
+  }
+  return TRUE;
+}
+
+static GdkFilterReturn event_filter_cb(GdkXEvent *gdk_xevent, GdkEvent *event,
+                                       gpointer user_data)
+{
+  PointerForwarder *self = POINTER_FORWARDER(user_data);
+  XEvent *xevent = static_cast<XEvent *>(gdk_xevent);
+  XGenericEventCookie *cookie = &xevent->xcookie;
+  if (!self->capturing || xevent->type != GenericEvent ||
+      cookie->extension != self->xi_opcode || cookie->evtype != XI_RawMotion)
+  {
+    return GDK_FILTER_CONTINUE;
+  }
+
+  // GDK normally fetches the cookie data before running filters.
+  gboolean fetched = FALSE;
+  if (cookie->data == nullptr)
+  {
+    fetched = XGetEventData(cookie->display, cookie);
+  }
+  gboolean handled = FALSE;
+  if (cookie->data != nullptr)
+  {
+    handled = handle_raw_event(self, cookie->display,
+                               static_cast<XIRawEvent *>(cookie->data));
+  }
+  if (fetched)
+  {
+    XFreeEventData(cookie->display, cookie);
+  }
+  return handled ? GDK_FILTER_REMOVE : GDK_FILTER_CONTINUE;
+}
+
+// Adds or removes raw motion in the root window's master-devices selection.
+// The all-devices selection is left to the scroll forwarder, and the bits
+// selected here for edge barriers are kept.
+static void select_raw_events(Display *xdisplay, gboolean enable)
+{
+  Window root = DefaultRootWindow(xdisplay);
+  unsigned char mask_bits[XIMaskLen(XI_LASTEVENT)] = {};
+
+  int count = 0;
+  XIEventMask *selected = XIGetSelectedEvents(xdisplay, root, &count);
+  for (int i = 0; selected != nullptr && i < count; i++)
+  {
+    if (selected[i].deviceid == XIAllMasterDevices)
+    {
+      memcpy(mask_bits, selected[i].mask,
+             MIN(selected[i].mask_len, static_cast<int>(sizeof(mask_bits))));
+    }
+  }
+  if (selected != nullptr)
+  {
+    XFree(selected);
+  }
+
+  if (enable)
+    XISetMask(mask_bits, XI_RawMotion);
+  else
+    XIClearMask(mask_bits, XI_RawMotion);
+
+  XIEventMask mask;
+  mask.deviceid = XIAllMasterDevices;
+  mask.mask_len = sizeof(mask_bits);
+  mask.mask = mask_bits;
+  XISelectEvents(xdisplay, root, &mask, 1);
+  XFlush(xdisplay);
+}
+
+// Raw events of master devices need XInput 2.1.
+static gboolean query_xinput(PointerForwarder *self, Display *xdisplay)
+{
+  int event, error;
+  if (!XQueryExtension(xdisplay, "XInputExtension", &self->xi_opcode, &event,
+                       &error))
+  {
+    return FALSE;
+  }
+
+  int major = 2, minor = 1;
+  return XIQueryVersion(xdisplay, &major, &minor) == Success &&
+         major * 10 + minor >= 21;
+}
+#endif
+
+static FlMethodResponse *start_capture(PointerForwarder *self)
+{
+#ifdef GDK_WINDOWING_X11
+  Display *xdisplay = get_xdisplay();
+  if (xdisplay != nullptr && self->xi_opcode != 0)
+  {
+    if (!self->capturing)
+    {
+      self->capturing = TRUE;
+      g_hash_table_remove_all(self->relative_devices);
+      select_raw_events(xdisplay, TRUE);
+      update_grab(self);
+    }
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+  }
+#endif
+  return FL_METHOD_RESPONSE(fl_method_error_response_new(
+      "unsupported", "Pointer capture requires X11 with XInput 2.1", nullptr));
+}
+
+static void stop_capture(PointerForwarder *self)
+{
+  if (!self->capturing)
+  {
+    return;
+  }
+  self->capturing = FALSE;
+  reset_capture(self);
+  update_grab(self);
+#ifdef GDK_WINDOWING_X11
+  Display *xdisplay = get_xdisplay();
+  if (xdisplay != nullptr)
+  {
+    select_raw_events(xdisplay, FALSE);
+  }
+#endif
+}
+
+static FlMethodResponse *warp(PointerForwarder *self, FlValue *args)
+{
+  FlValue *x = fl_value_lookup_string(args, "x");
+  FlValue *y = fl_value_lookup_string(args, "y");
+  if (x == nullptr || fl_value_get_type(x) != FL_VALUE_TYPE_FLOAT ||
+      y == nullptr || fl_value_get_type(y) != FL_VALUE_TYPE_FLOAT)
+  {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad-args", "warp expects x and y", nullptr));
+  }
+
+#ifdef GDK_WINDOWING_X11
+  Display *xdisplay = get_xdisplay();
+  if (xdisplay != nullptr && self->xtest)
+  {
+    XTestFakeMotionEvent(xdisplay, -1, fl_value_get_float(x),
+                         fl_value_get_float(y), CurrentTime);
+    XFlush(xdisplay);
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+  }
+#endif
+  return FL_METHOD_RESPONSE(fl_method_error_response_new(
+      "unsupported", "Pointer injection requires X11 with XTest", nullptr));
+}
+
+static FlMethodResponse *get_screen_size()
+{
+#ifdef GDK_WINDOWING_X11
+  Display *xdisplay = get_xdisplay();
+  if (xdisplay != nullptr)
+  {
+    int screen = DefaultScreen(xdisplay);
+    g_autoptr(FlValue) result = fl_value_new_map();
+    fl_value_set_string_take(result, "width",
+                             fl_value_new_int(DisplayWidth(xdisplay, screen)));
+    fl_value_set_string_take(
+        result, "height", fl_value_new_int(DisplayHeight(xdisplay, screen)));
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  }
+#endif
+  return FL_METHOD_RESPONSE(fl_method_error_response_new(
+      "unsupported", "Screen size is only known on X11", nullptr));
+}
+
+static void method_call_cb(FlMethodChannel *channel, FlMethodCall *method_call,
+                           gpointer user_data)
+{
+  PointerForwarder *self = POINTER_FORWARDER(user_data);
+  const gchar *method = fl_method_call_get_name(method_call);
+  FlValue *args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "startCapture") == 0)
+  {
+    response = start_capture(self);
+  }
+  else if (strcmp(method, "stopCapture") == 0)
+  {
+    stop_capture(self);
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+  }
+  else if (strcmp(method, "warp") == 0 &&
+           fl_value_get_type(args) == FL_VALUE_TYPE_MAP)
+  {
+    response = warp(self, args);
+  }
+  else if (strcmp(method, "getScreenSize") == 0)
+  {
+    response = get_screen_size();
+  }
+  else
+  {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error))
+  {
+    g_warning("Failed to respond to %s: %s", method, error->message);
+  }
+}
+
+// Implements GObject::dispose.
+static void pointer_forwarder_dispose(GObject *object)
+{
+  PointerForwarder *self = POINTER_FORWARDER(object);
+
+#ifdef GDK_WINDOWING_X11
+  gdk_window_remove_filter(nullptr, event_filter_cb, self);
+#endif
+  stop_capture(self);
+  g_clear_pointer(&self->relative_devices, g_hash_table_unref);
+  if (self->switcher != nullptr)
+  {
+    g_signal_handlers_disconnect_by_data(self->switcher, self);
+  }
+
+  if (self->channel != nullptr)
+  {
+    fl_method_channel_set_method_call_handler(self->channel, nullptr, nullptr,
+                                              nullptr);
+  }
+  g_clear_object(&self->channel);
+  g_clear_object(&self->switcher);
+
+  G_OBJECT_CLASS(pointer_forwarder_parent_class)->dispose(object);
+}
+
+static void pointer_forwarder_class_init(PointerForwarderClass *klass)
+{
+  G_OBJECT_CLASS(klass)->dispose = pointer_forwarder_dispose;
+}
+
+static void pointer_forwarder_init(PointerForwarder *self)
+{
+  self->relative_devices = g_hash_table_new(g_direct_hash, g_direct_equal);
+}
+
+PointerForwarder *pointer_forwarder_new(FlBinaryMessenger *messenger,
+                                        FocusSwitcher *switcher)
+{
+  PointerForwarder *self =
+      POINTER_FORWARDER(g_object_new(pointer_forwarder_get_type(), nullptr));
+  self->switcher = FOCUS_SWITCHER(g_object_ref(switcher));
+  g_signal_connect(switcher, "switched", G_CALLBACK(switched_cb), self);
+
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  self->channel = fl_method_channel_new(messenger, "desk_switch/pointer",
+                                        FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(self->channel, method_call_cb,
+                                            self, nullptr);
+
+#ifdef GDK_WINDOWING_X11
+  Display *xdisplay = get_xdisplay();
+  if (xdisplay != nullptr)
+  {
+    if (query_xinput(self, xdisplay))
+    {
+      gdk_window_add_filter(nullptr, event_filter_cb, self);
+    }
+    else
+    {
+      self->xi_opcode = 0;
+      g_warning("XInput 2.1 is unavailable; pointer capture is off");
+    }
+
+    int event_base, error_base, major, minor;
+    self->xtest = XTestQueryExtension(xdisplay, &event_base, &error_base,
+                                      &major, &minor);
+  }
+#endif
+
+  return self;
+}
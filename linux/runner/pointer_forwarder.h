@@ -0,0 +1,33 @@
+#ifndef FLUTTER_POINTER_FORWARDER_H_
+#define FLUTTER_POINTER_FORWARDER_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <gtk/gtk.h>
+
+#include "focus_switcher.h"
+
+G_DECLARE_FINAL_TYPE(PointerForwarder, pointer_forwarder, POINTER, FORWARDER,
+                     GObject)
+
+/**
+ * pointer_forwarder_new:
+ * @messenger: the engine's binary messenger.
+ * @switcher: the #FocusSwitcher that decides whether the pointer is remote.
+ *
+ * Creates the pointer path behind the `desk_switch/pointer` method channel.
+ *
+ * On the controlling machine, `startCapture` reads relative motion from
+ * XInput2 raw events of the master pointer. While a remote machine has
+ * focus, it is summed per frame and reported to Dart as `motion`, and the
+ * local pointer is grabbed through the #FocusSwitcher so it stays still
+ * and local windows see none of its events. On the
+ * controlled machine, `warp` moves the local pointer to an absolute
+ * position through XTest, and `getScreenSize` reports the bounds of that
+ * position.
+ *
+ * Returns: a new #PointerForwarder.
+ */
+PointerForwarder* pointer_forwarder_new(FlBinaryMessenger* messenger,
+                                        FocusSwitcher* switcher);
+
+#endif  // FLUTTER_POINTER_FORWARDER_H_
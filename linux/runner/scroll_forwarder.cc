@@ -0,0 +1,718 @@
+#include "scroll_forwarder.h"
+
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+#ifdef GDK_WINDOWING_X11
+#include <X11/Xlib.h>
+#include <X11/extensions/XInput2.h>
+#include <gdk/gdkx.h>
+#endif
+
+// Older kernel headers predate the high-resolution wheel axes.
+#ifndef REL_WHEEL_HI_RES
+#define REL_WHEEL_HI_RES 0x0b
+#endif
+#ifndef REL_HWHEEL_HI_RES
+#define REL_HWHEEL_HI_RES 0x0c
+#endif
+
+// Fixed-point scroll unit: 1/120 of a wheel detent, as in REL_WHEEL_HI_RES.
+static const gint32 kUnitsPerDetent = 120;
+
+// Capture frame; scroll is summed over this window before it is sent.
+static const guint kFrameMs = 8;
+
+// Length of one injected step when a frame is replayed.
+static const gint64 kStepUs = 2000;
+static const gint kMaxSteps = 8;
+
+// Longest duration accepted for one frame.
+static const gint64 kMaxFrameUs = 100000;
+
+// Frames queued beyond this are folded together to catch up after a
+// network stall instead of replaying ever further behind.
+static const gint kMaxBacklog = 2;
+
+// A gap this long between frames ends the gesture; the next one starts on
+// a clean detent.
+static const gint64 kGesturePauseUs = 100000;
+
+typedef struct
+{
+  gint deviceid;
+  gint number;
+  gboolean vertical;
+  double increment;
+} ScrollAxis;
+
+typedef struct
+{
+  gint32 dx;
+  gint32 dy;
+  gint64 duration_us;
+} ScrollFrame;
+
+// Pushed by stop_injection() to wake the inject thread and end it. Never
+// freed, unlike the frames around it.
+static ScrollFrame stop_frame;
+
+struct _ScrollForwarder
+{
+  GObject parent_instance;
+  FlMethodChannel *channel;
+  FocusSwitcher *switcher;
+
+  // Capture side, main thread only.
+  gint xi_opcode;
+  gboolean capturing;
+  // Whether this module holds the switcher's local pointer grab.
+  gboolean holding_grab;
+  GArray *axes;
+  double pending_x;
+  double pending_y;
+  gint64 frame_start_us;
+  guint flush_source;
+
+  // Injection side.
+  int uinput_fd;
+  gboolean uinput_failed;
+  GThread *inject_thread;
+  GAsyncQueue *frames;
+};
+
+G_DEFINE_TYPE(ScrollForwarder, scroll_forwarder, G_TYPE_OBJECT)
+
+// Sends the whole units summed over the last frame to Dart. The fraction
+// carries over, so a slow touchpad scroll never rounds away to nothing.
+static gboolean flush_cb(gpointer user_data)
+{
+  ScrollForwarder *self = SCROLL_FORWARDER(user_data);
+  self->flush_source = 0;
+
+  double dx = std::trunc(self->pending_x);
+  double dy = std::trunc(self->pending_y);
+  self->pending_x -= dx;
+  self->pending_y -= dy;
+  if (dx == 0 && dy == 0)
+  {
+    return G_SOURCE_REMOVE;
+  }
+
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "dx",
+                           fl_value_new_int(static_cast<int64_t>(dx)));
+  fl_value_set_string_take(args, "dy",
+                           fl_value_new_int(static_cast<int64_t>(dy)));
+  fl_value_set_string_take(
+      args, "durationUs",
+      fl_value_new_int(g_get_monotonic_time() - self->frame_start_us));
+  fl_method_channel_invoke_method(self->channel, "scroll", args, nullptr,
+                                  nullptr, nullptr);
+  return G_SOURCE_REMOVE;
+}
+
+// Keeps the wheel out of local windows while its scrolling goes to a
+// remote machine.
+static void update_grab(ScrollForwarder *self)
+{
+  gboolean wanted = self->capturing &&
+                    focus_switcher_get_active_target(self->switcher) != 0;
+  if (wanted == self->holding_grab)
+  {
+    return;
+  }
+  self->holding_grab = wanted;
+  if (wanted)
+    focus_switcher_grab_pointer(self->switcher);
+  else
+    focus_switcher_ungrab_pointer(self->switcher);
+}
+
+static void switched_cb(FocusSwitcher *switcher, gint target, gint previous,
+                        gpointer user_data)
+{
+  update_grab(SCROLL_FORWARDER(user_data));
+}
+
+static void reset_capture(ScrollForwarder *self)
+{
+  if (self->flush_source != 0)
+  {
+    g_source_remove(self->flush_source);
+    self->flush_source = 0;
+  }
+  self->pending_x = 0;
+  self->pending_y = 0;
+}
+
+#ifdef GDK_WINDOWING_X11
+static Display *get_xdisplay()
+{
+  GdkDisplay *display = gdk_display_get_default();
+  if (display == nullptr || !GDK_IS_X11_DISPLAY(display))
+  {
+    return nullptr;
+  }
+  return GDK_DISPLAY_XDISPLAY(display);
+}
+
+// Finds the smooth-scroll valuators of every pointer. Called again on
+// hotplug, since each device numbers its valuators differently.
+static void query_axes(ScrollForwarder *self, Display *xdisplay)
+{
+  g_array_set_size(self->axes, 0);
+
+  int count = 0;
+  XIDeviceInfo *devices = XIQueryDevice(xdisplay, XIAllDevices, &count);
+  for (int i = 0; i < count; i++)
+  {
+    if (devices[i].use != XISlavePointer)
+    {
+      continue;
+    }
+    for (int j = 0; j < devices[i].num_classes; j++)
+    {
+      if (devices[i].classes[j]->type != XIScrollClass)
+      {
+        continue;
+      }
+      XIScrollClassInfo *scroll =
+          reinterpret_cast<XIScrollClassInfo *>(devices[i].classes[j]);
+      if (scroll->increment == 0)
+      {
+        continue;
+      }
+      ScrollAxis axis;
+      axis.deviceid = devices[i].deviceid;
+      axis.number = scroll->number;
+      axis.vertical = scroll->scroll_type == XIScrollTypeVertical;
+      axis.increment = scroll->increment;
+      g_array_append_val(self->axes, axis);
+    }
+  }
+  XIFreeDeviceInfo(devices);
+}
+
+static const ScrollAxis *find_axis(ScrollForwarder *self, gint deviceid,
+                                   gint number)
+{
+  for (guint i = 0; i < self->axes->len; i++)
+  {
+    const ScrollAxis *axis = &g_array_index(self->axes, ScrollAxis, i);
+    if (axis->deviceid == deviceid && axis->number == number)
+    {
+      return axis;
+    }
+  }
+  return nullptr;
+}
+
+// Returns whether the event was meant for this module.
+static gboolean handle_raw_event(ScrollForwarder *self, XIRawEvent *event)
+{
+  // Raw events are delivered for the master device too; count the slave's
+  // and leave the master's to the pointer forwarder.
+  if (event->deviceid != event->sourceid)
+  {
+    return FALSE;
+  }
+
+  const double *values = event->valuators.values;
+  gboolean scrolled = FALSE;
+  for (int number = 0; number < event->valuators.mask_len * 8; number++)
+  {
+    if (!XIMaskIsSet(event->valuators.mask, number))
+    {
+      continue;
+    }
+    double value = *values++;
+    const ScrollAxis *axis = find_axis(self, event->deviceid, number);
+    if (axis == nullptr)
+    {
+      continue;
+    }
+
+    double units = value / axis->increment * kUnitsPerDetent;
+    if (axis->vertical)
+      self->pending_y += units;
+    else
+      self->pending_x += units;
+    scrolled = TRUE;
+  }
+  if (!scrolled)
+  {
+    return TRUE;
+  }
+
+  // Scrolling stays local while this machine has focus.
+  if (focus_switcher_get_active_target(self->switcher) == 0)
+  {
+    reset_capture(self);
+    return TRUE;
+  }
+
+  if (self->flush_source == 0)
+  {
+    self->frame_start_us = g_get_monotonic_time();
+    self->flush_source = g_timeout_add(kFrameMs, flush_cb, self);
+  }
+  return TRUE;
+}
+
+static GdkFilterReturn event_filter_cb(GdkXEvent *gdk_xevent, GdkEvent *event,
+                                       gpointer user_data)
+{
+  ScrollForwarder *self = SCROLL_FORWARDER(user_data);
+  XEvent *xevent = static_cast<XEvent *>(gdk_xevent);
+  XGenericEventCookie *cookie = &xevent->xcookie;
+  if (!self->capturing || xevent->type != GenericEvent ||
+      cookie->extension != self->xi_opcode ||
+      (cookie->evtype != XI_RawMotion &&
+       cookie->evtype != XI_HierarchyChanged &&
+       cookie->evtype != XI_DeviceChanged))
+  {
+    return GDK_FILTER_CONTINUE;
+  }
+
+  if (cookie->evtype != XI_RawMotion)
+  {
+    // GDK tracks devices too, so let these through.
+    query_axes(self, cookie->display);
+    return GDK_FILTER_CONTINUE;
+  }
+
+  // GDK normally fetches the cookie data before running filters.
+  gboolean fetched = FALSE;
+  if (cookie->data == nullptr)
+  {
+    fetched = XGetEventData(cookie->display, cookie);
+  }
+  gboolean handled = FALSE;
+  if (cookie->data != nullptr)
+  {
+    handled = handle_raw_event(self, static_cast<XIRawEvent *>(cookie->data));
+  }
+  if (fetched)
+  {
+    XFreeEventData(cookie->display, cookie);
+  }
+  return handled ? GDK_FILTER_REMOVE : GDK_FILTER_CONTINUE;
+}
+
+// Adds or removes raw events in the root window's all-devices selection,
+// keeping the bits GDK selected there for its own hotplug handling.
+static void select_raw_events(Display *xdisplay, gboolean enable)
+{
+  Window root = DefaultRootWindow(xdisplay);
+  unsigned char mask_bits[XIMaskLen(XI_LASTEVENT)] = {};
+
+  int count = 0;
+  XIEventMask *selected = XIGetSelectedEvents(xdisplay, root, &count);
+  for (int i = 0; selected != nullptr && i < count; i++)
+  {
+    if (selected[i].deviceid == XIAllDevices)
+    {
+      memcpy(mask_bits, selected[i].mask,
+             MIN(selected[i].mask_len, static_cast<int>(sizeof(mask_bits))));
+    }
+  }
+  if (selected != nullptr)
+  {
+    XFree(selected);
+  }
+
+  if (enable)
+  {
+    XISetMask(mask_bits, XI_RawMotion);
+    XISetMask(mask_bits, XI_HierarchyChanged);
+    XISetMask(mask_bits, XI_DeviceChanged);
+  }
+  else
+  {
+    XIClearMask(mask_bits, XI_RawMotion);
+  }
+
+  XIEventMask mask;
+  mask.deviceid = XIAllDevices;
+  mask.mask_len = sizeof(mask_bits);
+  mask.mask = mask_bits;
+  XISelectEvents(xdisplay, root, &mask, 1);
+  XFlush(xdisplay);
+}
+
+// Smooth-scroll valuators need XInput 2.1.
+static gboolean query_xinput(ScrollForwarder *self, Display *xdisplay)
+{
+  int event, error;
+  if (!XQueryExtension(xdisplay, "XInputExtension", &self->xi_opcode, &event,
+                       &error))
+  {
+    return FALSE;
+  }
+
+  int major = 2, minor = 1;
+  return XIQueryVersion(xdisplay, &major, &minor) == Success &&
+         major * 10 + minor >= 21;
+}
+#endif
+
+static FlMethodResponse *start_capture(ScrollForwarder *self)
+{
+#ifdef GDK_WINDOWING_X11
+  Display *xdisplay = get_xdisplay();
+  if (xdisplay == nullptr || self->xi_opcode == 0)
+  {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "unsupported", "Smooth scrolling requires X11 with XInput 2.1",
+        nullptr));
+  }
+
+  if (!self->capturing)
+  {
+    self->capturing = TRUE;
+    query_axes(self, xdisplay);
+    select_raw_events(xdisplay, TRUE);
+    update_grab(self);
+  }
+  return FL_METHOD_RESPONSE(
+      fl_method_success_response_new(fl_value_new_int(self->axes->len)));
+#else
+  return FL_METHOD_RESPONSE(fl_method_error_response_new(
+      "unsupported", "Smooth scrolling requires X11 with XInput 2.1",
+      nullptr));
+#endif
+}
+
+static void stop_capture(ScrollForwarder *self)
+{
+  if (!self->capturing)
+  {
+    return;
+  }
+  self->capturing = FALSE;
+  reset_capture(self);
+  update_grab(self);
+#ifdef GDK_WINDOWING_X11
+  Display *xdisplay = get_xdisplay();
+  if (xdisplay != nullptr)
+  {
+    select_raw_events(xdisplay, FALSE);
+  }
+#endif
+}
+
+static int open_uinput()
+{
+  int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0)
+  {
+    g_warning("Failed to open /dev/uinput: %s", g_strerror(errno));
+    return -1;
+  }
+
+  // libinput ignores scroll-only devices, so look like a wheel mouse.
+  static const int kRelAxes[] = {REL_X, REL_Y, REL_WHEEL, REL_HWHEEL,
+                                 REL_WHEEL_HI_RES, REL_HWHEEL_HI_RES};
+  gboolean ok = ioctl(fd, UI_SET_EVBIT, EV_KEY) >= 0 &&
+                ioctl(fd, UI_SET_KEYBIT, BTN_LEFT) >= 0 &&
+                ioctl(fd, UI_SET_EVBIT, EV_REL) >= 0;
+  for (int axis : kRelAxes)
+  {
+    ok = ok && ioctl(fd, UI_SET_RELBIT, axis) >= 0;
+  }
+
+  struct uinput_setup setup = {};
+  setup.id.bustype = BUS_VIRTUAL;
+  g_strlcpy(setup.name, "DeskSwitch virtual wheel", UINPUT_MAX_NAME_SIZE);
+  ok = ok && ioctl(fd, UI_DEV_SETUP, &setup) >= 0 &&
+       ioctl(fd, UI_DEV_CREATE) >= 0;
+  if (!ok)
+  {
+    g_warning("Failed to create uinput device: %s", g_strerror(errno));
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static void write_event(int fd, guint16 type, guint16 code, gint32 value)
+{
+  struct input_event event = {};
+  event.type = type;
+  event.code = code;
+  event.value = value;
+  if (write(fd, &event, sizeof(event)) != static_cast<ssize_t>(sizeof(event)))
+  {
+    g_debug("Dropped uinput event: %s", g_strerror(errno));
+  }
+}
+
+// Emits a high-resolution delta plus the legacy detents it completes;
+// @wheel carries the part of a detent not yet reported.
+static void write_wheel(int fd, guint16 hi_res_code, guint16 code,
+                        gint32 delta, gint32 *wheel)
+{
+  if (delta == 0)
+  {
+    return;
+  }
+  if ((*wheel > 0 && delta < 0) || (*wheel < 0 && delta > 0))
+  {
+    *wheel = 0;
+  }
+
+  write_event(fd, EV_REL, hi_res_code, delta);
+  *wheel += delta;
+  gint32 detents = *wheel / kUnitsPerDetent;
+  if (detents != 0)
+  {
+    write_event(fd, EV_REL, code, detents);
+    *wheel -= detents * kUnitsPerDetent;
+  }
+}
+
+static gpointer inject_thread_func(gpointer data)
+{
+  ScrollForwarder *self = SCROLL_FORWARDER(data);
+  gint32 wheel_x = 0;
+  gint32 wheel_y = 0;
+  gint64 last_frame_us = 0;
+
+  for (;;)
+  {
+    ScrollFrame *frame =
+        static_cast<ScrollFrame *>(g_async_queue_pop(self->frames));
+    if (frame == &stop_frame)
+    {
+      break;
+    }
+
+    if (g_get_monotonic_time() - last_frame_us > kGesturePauseUs)
+    {
+      wheel_x = wheel_y = 0;
+    }
+
+    while (g_async_queue_length(self->frames) >= kMaxBacklog)
+    {
+      ScrollFrame *next =
+          static_cast<ScrollFrame *>(g_async_queue_try_pop(self->frames));
+      if (next == &stop_frame)
+      {
+        g_free(frame);
+        return nullptr;
+      }
+      if (next == nullptr)
+      {
+        break;
+      }
+      frame->dx += next->dx;
+      frame->dy += next->dy;
+      g_free(next);
+    }
+
+    // Spread the frame over the time it took to capture, splitting the
+    // integer deltas so no unit is lost to rounding.
+    gint steps = CLAMP(frame->duration_us / kStepUs, 1, kMaxSteps);
+    gint64 step_us = frame->duration_us / steps;
+    gint32 sent_x = 0, sent_y = 0;
+    for (gint i = 1; i <= steps; i++)
+    {
+      gint32 x = static_cast<gint64>(frame->dx) * i / steps;
+      gint32 y = static_cast<gint64>(frame->dy) * i / steps;
+      if (x != sent_x || y != sent_y)
+      {
+        // REL_WHEEL counts upwards; the wire counts downwards like XI2.
+        write_wheel(self->uinput_fd, REL_WHEEL_HI_RES, REL_WHEEL,
+                    -(y - sent_y), &wheel_y);
+        write_wheel(self->uinput_fd, REL_HWHEEL_HI_RES, REL_HWHEEL,
+                    x - sent_x, &wheel_x);
+        write_event(self->uinput_fd, EV_SYN, SYN_REPORT, 0);
+        sent_x = x;
+        sent_y = y;
+      }
+      g_usleep(step_us);
+    }
+    g_free(frame);
+    last_frame_us = g_get_monotonic_time();
+  }
+  return nullptr;
+}
+
+static FlMethodResponse *inject(ScrollForwarder *self, FlValue *args)
+{
+  FlValue *dx = fl_value_lookup_string(args, "dx");
+  FlValue *dy = fl_value_lookup_string(args, "dy");
+  FlValue *duration = fl_value_lookup_string(args, "durationUs");
+  if (dx == nullptr || fl_value_get_type(dx) != FL_VALUE_TYPE_INT ||
+      dy == nullptr || fl_value_get_type(dy) != FL_VALUE_TYPE_INT ||
+      duration == nullptr || fl_value_get_type(duration) != FL_VALUE_TYPE_INT)
+  {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad-args", "inject expects dx, dy and durationUs", nullptr));
+  }
+
+  if (self->uinput_fd < 0)
+  {
+    if (!self->uinput_failed)
+    {
+      self->uinput_fd = open_uinput();
+      self->uinput_failed = self->uinput_fd < 0;
+    }
+    if (self->uinput_failed)
+    {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          "unavailable", "Cannot create a uinput device", nullptr));
+    }
+    self->inject_thread =
+        g_thread_new("scroll-inject", inject_thread_func, self);
+  }
+
+  ScrollFrame *frame = g_new(ScrollFrame, 1);
+  frame->dx = fl_value_get_int(dx);
+  frame->dy = fl_value_get_int(dy);
+  frame->duration_us = CLAMP(fl_value_get_int(duration), 0, kMaxFrameUs);
+  g_async_queue_push(self->frames, frame);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+static void stop_injection(ScrollForwarder *self)
+{
+  if (self->inject_thread != nullptr)
+  {
+    g_async_queue_push(self->frames, &stop_frame);
+    g_thread_join(self->inject_thread);
+    self->inject_thread = nullptr;
+  }
+  if (self->uinput_fd >= 0)
+  {
+    ioctl(self->uinput_fd, UI_DEV_DESTROY);
+    close(self->uinput_fd);
+    self->uinput_fd = -1;
+  }
+  while (gpointer frame = g_async_queue_try_pop(self->frames))
+  {
+    g_free(frame);
+  }
+}
+
+static void method_call_cb(FlMethodChannel *channel, FlMethodCall *method_call,
+                           gpointer user_data)
+{
+  ScrollForwarder *self = SCROLL_FORWARDER(user_data);
+  const gchar *method = fl_method_call_get_name(method_call);
+  FlValue *args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "startCapture") == 0)
+  {
+    response = start_capture(self);
+  }
+  else if (strcmp(method, "stopCapture") == 0)
+  {
+    stop_capture(self);
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+  }
+  else if (strcmp(method, "inject") == 0 &&
+           fl_value_get_type(args) == FL_VALUE_TYPE_MAP)
+  {
+    response = inject(self, args);
+  }
+  else if (strcmp(method, "stopInjection") == 0)
+  {
+    stop_injection(self);
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+  }
+  else
+  {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error))
+  {
+    g_warning("Failed to respond to %s: %s", method, error->message);
+  }
+}
+
+// Implements GObject::dispose.
+static void scroll_forwarder_dispose(GObject *object)
+{
+  ScrollForwarder *self = SCROLL_FORWARDER(object);
+
+#ifdef GDK_WINDOWING_X11
+  gdk_window_remove_filter(nullptr, event_filter_cb, self);
+#endif
+  stop_capture(self);
+  if (self->frames != nullptr)
+  {
+    stop_injection(self);
+  }
+  g_clear_pointer(&self->frames, g_async_queue_unref);
+  g_clear_pointer(&self->axes, g_array_unref);
+  if (self->switcher != nullptr)
+  {
+    g_signal_handlers_disconnect_by_data(self->switcher, self);
+  }
+
+  if (self->channel != nullptr)
+  {
+    fl_method_channel_set_method_call_handler(self->channel, nullptr, nullptr,
+                                              nullptr);
+  }
+  g_clear_object(&self->channel);
+  g_clear_object(&self->switcher);
+
+  G_OBJECT_CLASS(scroll_forwarder_parent_class)->dispose(object);
+}
+
+static void scroll_forwarder_class_init(ScrollForwarderClass *klass)
+{
+  G_OBJECT_CLASS(klass)->dispose = scroll_forwarder_dispose;
+}
+
+static void scroll_forwarder_init(ScrollForwarder *self)
+{
+  self->axes = g_array_new(FALSE, TRUE, sizeof(ScrollAxis));
+  self->frames = g_async_queue_new_full(g_free);
+  self->uinput_fd = -1;
+}
+
+ScrollForwarder *scroll_forwarder_new(FlBinaryMessenger *messenger,
+                                      FocusSwitcher *switcher)
+{
+  ScrollForwarder *self =
+      SCROLL_FORWARDER(g_object_new(scroll_forwarder_get_type(), nullptr));
+  self->switcher = FOCUS_SWITCHER(g_object_ref(switcher));
+  g_signal_connect(switcher, "switched", G_CALLBACK(switched_cb), self);
+
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  self->channel = fl_method_channel_new(messenger, "desk_switch/scroll",
+                                        FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(self->channel, method_call_cb,
+                                            self, nullptr);
+
+#ifdef GDK_WINDOWING_X11
+  Display *xdisplay = get_xdisplay();
+  if (xdisplay != nullptr)
+  {
+    if (query_xinput(self, xdisplay))
+    {
+      gdk_window_add_filter(nullptr, event_filter_cb, self);
+    }
+    else
+    {
+      self->xi_opcode = 0;
+      g_warning("XInput 2.1 is unavailable; smooth scroll capture is off");
+    }
+  }
+#endif
+
+  return self;
+}
@@ -0,0 +1,34 @@
+#ifndef FLUTTER_SCROLL_FORWARDER_H_
+#define FLUTTER_SCROLL_FORWARDER_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <gtk/gtk.h>
+
+#include "focus_switcher.h"
+
+G_DECLARE_FINAL_TYPE(ScrollForwarder, scroll_forwarder, SCROLL, FORWARDER,
+                     GObject)
+
+/**
+ * scroll_forwarder_new:
+ * @messenger: the engine's binary messenger.
+ * @switcher: the #FocusSwitcher that decides whether scrolling is remote.
+ *
+ * Creates the high-resolution scroll path behind the `desk_switch/scroll`
+ * method channel.
+ *
+ * On the controlling machine, `startCapture` reads XInput2 smooth-scroll
+ * valuators from raw events. While a remote machine has focus, it sums
+ * them per frame in 1/120 of a wheel detent and reports each frame to Dart
+ * as `scroll`, holding the #FocusSwitcher's local pointer grab so local
+ * windows do not scroll along. On the controlled machine, `inject` replays
+ * frames through a uinput device with REL_WHEEL_HI_RES. Each frame is
+ * spread over its original duration so the scroll velocity survives the
+ * trip.
+ *
+ * Returns: a new #ScrollForwarder.
+ */
+ScrollForwarder* scroll_forwarder_new(FlBinaryMessenger* messenger,
+                                      FocusSwitcher* switcher);
+
+#endif  // FLUTTER_SCROLL_FORWARDER_H_
@@ -0,0 +1,488 @@
+#include "session_snapshot.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+static const guint32 kMagic = 0x534b5344;  // "DSKS"
+static const guint32 kLayoutVersion = 5;
+static const guint kMaxPeers = 16;
+static const gchar *kBootIdPath = "/proc/sys/kernel/random/boot_id";
+
+// Peers give up on a session after the server's two-minute resume grace
+// period, so an older snapshot has nothing left to resume.
+static const gint64 kMaxAgeUs = 2 * 60 * G_USEC_PER_SEC;
+
+// Commits follow changes, so a quiet session is re-stamped this often to
+// keep its age meaningful.
+static const guint kStampIntervalS = 30;
+
+// Fixed-size records so the file can be mapped as-is. Strings are
+// NUL-terminated and truncated to fit.
+typedef struct
+{
+  char peer_id[48];
+  char session_id[48];
+  char session_key[48];
+  char name[64];
+  char host[64];
+  guint16 port;
+  guint16 reserved;
+  guint32 resume_sequence;
+} SnapshotPeer;
+
+typedef struct
+{
+  // Covers everything after this field.
+  guint32 crc;
+  guint32 reserved;
+  guint64 generation;
+  gint64 saved_at_us;
+  // Monotonic time of the commit, comparable between runs of one boot.
+  gint64 stamped_us;
+  // A snapshot only outlives a crash of this boot; a reboot has already
+  // dropped every connection.
+  char boot_id[40];
+  gint32 role;
+  guint32 peer_count;
+  gint32 local_port;
+  gint32 active_target;
+  gint32 target_count;
+  SnapshotPeer peers[kMaxPeers];
+} SnapshotSlot;
+
+// Two slots written alternately: a commit fills the inactive one and then
+// flips active_slot, so a crash halfway through a write still leaves the
+// previous state readable.
+typedef struct
+{
+  guint32 magic;
+  guint32 layout_version;
+  guint32 slot_size;
+  gint32 active_slot;
+  SnapshotSlot slots[2];
+} SnapshotFile;
+
+struct _SessionSnapshot
+{
+  GObject parent_instance;
+  FlMethodChannel *channel;
+  FocusSwitcher *switcher;
+
+  int fd;
+  SnapshotFile *file;
+  guint stamp_source;
+  // Warn once each time the peers outgrow the slot, not on every update.
+  gboolean warned_peer_limit;
+
+  // Working copy, written out by commit().
+  SnapshotSlot current;
+
+  // Stamped on every slot; a snapshot from another boot is never restored,
+  // nor is any snapshot while the boot is unknown.
+  char boot_id[40];
+
+  // What the previous run left behind.
+  gboolean has_restored;
+  SnapshotSlot restored;
+};
+
+G_DEFINE_TYPE(SessionSnapshot, session_snapshot, G_TYPE_OBJECT)
+
+static guint32 crc32(const guint8 *data, gsize length)
+{
+  guint32 crc = 0xffffffff;
+  for (gsize i = 0; i < length; i++)
+  {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+    {
+      crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+    }
+  }
+  return ~crc;
+}
+
+static guint32 slot_crc(const SnapshotSlot *slot)
+{
+  const guint8 *start =
+      reinterpret_cast<const guint8 *>(slot) + sizeof(slot->crc);
+  return crc32(start, sizeof(*slot) - sizeof(slot->crc));
+}
+
+static gboolean map_file(SessionSnapshot *self)
+{
+  g_autofree gchar *dir =
+      g_build_filename(g_get_user_runtime_dir(), "desk_switch", nullptr);
+  if (g_mkdir_with_parents(dir, 0700) != 0)
+  {
+    g_warning("Failed to create %s: %s", dir, g_strerror(errno));
+    return FALSE;
+  }
+
+  g_autofree gchar *path = g_build_filename(dir, "session.snapshot", nullptr);
+  int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (fd < 0)
+  {
+    g_warning("Failed to open %s: %s", path, g_strerror(errno));
+    return FALSE;
+  }
+
+  // A second instance runs without a snapshot rather than fighting over it.
+  if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+  {
+    g_message("Session snapshot in use by another instance");
+    close(fd);
+    return FALSE;
+  }
+
+  void *data = MAP_FAILED;
+  if (ftruncate(fd, sizeof(SnapshotFile)) == 0)
+  {
+    data = mmap(nullptr, sizeof(SnapshotFile), PROT_READ | PROT_WRITE,
+                MAP_SHARED, fd, 0);
+  }
+  if (data == MAP_FAILED)
+  {
+    g_warning("Failed to map %s: %s", path, g_strerror(errno));
+    close(fd);
+    return FALSE;
+  }
+
+  self->fd = fd;
+  self->file = static_cast<SnapshotFile *>(data);
+  return TRUE;
+}
+
+// Reads the newest intact slot left by a previous run.
+static gboolean load(SessionSnapshot *self)
+{
+  const SnapshotFile *file = self->file;
+  if (file->magic != kMagic || file->layout_version != kLayoutVersion ||
+      file->slot_size != sizeof(SnapshotSlot))
+  {
+    return FALSE;
+  }
+
+  gint active = __atomic_load_n(&file->active_slot, __ATOMIC_ACQUIRE);
+  const SnapshotSlot *found = nullptr;
+  for (gint i = 0; i < 2 && found == nullptr; i++)
+  {
+    const SnapshotSlot *slot = &file->slots[(active + i) & 1];
+    if (slot->generation != 0 && slot->crc == slot_crc(slot))
+    {
+      found = slot;
+    }
+  }
+  if (found == nullptr || self->boot_id[0] == '\0' ||
+      strncmp(found->boot_id, self->boot_id, sizeof(self->boot_id)) != 0)
+  {
+    return FALSE;
+  }
+  gint64 age_us = g_get_monotonic_time() - found->stamped_us;
+  if (age_us > kMaxAgeUs)
+  {
+    g_message("Session snapshot is %" G_GINT64_FORMAT " s old; starting anew",
+              age_us / G_USEC_PER_SEC);
+    return FALSE;
+  }
+  self->restored = *found;
+
+  SnapshotSlot *restored = &self->restored;
+  restored->peer_count = MIN(restored->peer_count, kMaxPeers);
+  for (guint i = 0; i < restored->peer_count; i++)
+  {
+    SnapshotPeer *peer = &restored->peers[i];
+    peer->peer_id[sizeof(peer->peer_id) - 1] = '\0';
+    peer->session_id[sizeof(peer->session_id) - 1] = '\0';
+    peer->session_key[sizeof(peer->session_key) - 1] = '\0';
+    peer->name[sizeof(peer->name) - 1] = '\0';
+    peer->host[sizeof(peer->host) - 1] = '\0';
+  }
+  return TRUE;
+}
+
+static void commit(SessionSnapshot *self)
+{
+  if (self->file == nullptr)
+  {
+    return;
+  }
+
+  SnapshotSlot *slot = &self->current;
+  slot->generation++;
+  slot->saved_at_us = g_get_real_time();
+  slot->stamped_us = g_get_monotonic_time();
+  memcpy(slot->boot_id, self->boot_id, sizeof(slot->boot_id));
+  slot->crc = slot_crc(slot);
+
+  gint next = (self->file->active_slot + 1) & 1;
+  memcpy(&self->file->slots[next], slot, sizeof(*slot));
+  __atomic_store_n(&self->file->active_slot, next, __ATOMIC_RELEASE);
+}
+
+static gboolean stamp_cb(gpointer user_data)
+{
+  commit(SESSION_SNAPSHOT(user_data));
+  return G_SOURCE_CONTINUE;
+}
+
+static void read_boot_id(SessionSnapshot *self)
+{
+  g_autofree gchar *contents = nullptr;
+  g_autoptr(GError) error = nullptr;
+  if (!g_file_get_contents(kBootIdPath, &contents, nullptr, &error))
+  {
+    g_warning("Failed to read the boot id: %s", error->message);
+    return;
+  }
+  g_strlcpy(self->boot_id, g_strstrip(contents), sizeof(self->boot_id));
+}
+
+static void copy_string(char *dest, gsize size, FlValue *map,
+                        const gchar *key)
+{
+  FlValue *value = fl_value_lookup_string(map, key);
+  g_strlcpy(dest, value != nullptr &&
+                          fl_value_get_type(value) == FL_VALUE_TYPE_STRING
+                      ? fl_value_get_string(value)
+                      : "",
+            size);
+}
+
+static gint64 lookup_int(FlValue *map, const gchar *key)
+{
+  FlValue *value = fl_value_lookup_string(map, key);
+  return value != nullptr && fl_value_get_type(value) == FL_VALUE_TYPE_INT
+             ? fl_value_get_int(value)
+             : 0;
+}
+
+static FlMethodResponse *update(SessionSnapshot *self, FlValue *args)
+{
+  FlValue *peers = fl_value_lookup_string(args, "peers");
+  if (peers == nullptr || fl_value_get_type(peers) != FL_VALUE_TYPE_LIST)
+  {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad-args", "update expects a list of peers", nullptr));
+  }
+
+  SnapshotSlot *slot = &self->current;
+  slot->role = lookup_int(args, "role");
+  slot->local_port = lookup_int(args, "localPort");
+  slot->active_target = focus_switcher_get_active_target(self->switcher);
+  slot->target_count = focus_switcher_get_target_count(self->switcher);
+
+  size_t peer_count = fl_value_get_length(peers);
+  if (peer_count > kMaxPeers && !self->warned_peer_limit)
+  {
+    g_warning("Session snapshot keeps %u of %zu peers; the rest cannot "
+              "resume after a crash",
+              kMaxPeers, peer_count);
+  }
+  self->warned_peer_limit = peer_count > kMaxPeers;
+  slot->peer_count = MIN(peer_count, kMaxPeers);
+  memset(slot->peers, 0, sizeof(slot->peers));
+  for (guint i = 0; i < slot->peer_count; i++)
+  {
+    FlValue *entry = fl_value_get_list_value(peers, i);
+    if (fl_value_get_type(entry) != FL_VALUE_TYPE_MAP)
+    {
+      continue;
+    }
+    SnapshotPeer *peer = &slot->peers[i];
+    copy_string(peer->peer_id, sizeof(peer->peer_id), entry, "peerId");
+    copy_string(peer->session_id, sizeof(peer->session_id), entry,
+                "sessionId");
+    copy_string(peer->session_key, sizeof(peer->session_key), entry,
+                "sessionKey");
+    copy_string(peer->name, sizeof(peer->name), entry, "name");
+    copy_string(peer->host, sizeof(peer->host), entry, "host");
+    peer->port = lookup_int(entry, "port");
+    peer->resume_sequence = lookup_int(entry, "resumeSequence");
+  }
+
+  commit(self);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+static FlMethodResponse *restore(SessionSnapshot *self)
+{
+  if (!self->has_restored)
+  {
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+  }
+
+  const SnapshotSlot *slot = &self->restored;
+  g_autoptr(FlValue) peers = fl_value_new_list();
+  for (guint i = 0; i < slot->peer_count; i++)
+  {
+    const SnapshotPeer *peer = &slot->peers[i];
+    g_autoptr(FlValue) entry = fl_value_new_map();
+    fl_value_set_string_take(entry, "peerId",
+                             fl_value_new_string(peer->peer_id));
+    fl_value_set_string_take(entry, "sessionId",
+                             fl_value_new_string(peer->session_id));
+    fl_value_set_string_take(entry, "sessionKey",
+                             fl_value_new_string(peer->session_key));
+    fl_value_set_string_take(entry, "name", fl_value_new_string(peer->name));
+    fl_value_set_string_take(entry, "host", fl_value_new_string(peer->host));
+    fl_value_set_string_take(entry, "port", fl_value_new_int(peer->port));
+    fl_value_set_string_take(entry, "resumeSequence",
+                             fl_value_new_int(peer->resume_sequence));
+    fl_value_append(peers, entry);
+  }
+
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "savedAtUs",
+                           fl_value_new_int(slot->saved_at_us));
+  fl_value_set_string_take(result, "role", fl_value_new_int(slot->role));
+  fl_value_set_string_take(result, "localPort",
+                           fl_value_new_int(slot->local_port));
+  fl_value_set_string_take(result, "activeTarget",
+                           fl_value_new_int(slot->active_target));
+  fl_value_set_string_take(result, "targetCount",
+                           fl_value_new_int(slot->target_count));
+  fl_value_set_string(result, "peers", peers);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static void method_call_cb(FlMethodChannel *channel, FlMethodCall *method_call,
+                           gpointer user_data)
+{
+  SessionSnapshot *self = SESSION_SNAPSHOT(user_data);
+  const gchar *method = fl_method_call_get_name(method_call);
+  FlValue *args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "restore") == 0)
+  {
+    response = restore(self);
+  }
+  else if (strcmp(method, "update") == 0 &&
+           fl_value_get_type(args) == FL_VALUE_TYPE_MAP)
+  {
+    response = update(self, args);
+  }
+  else
+  {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error))
+  {
+    g_warning("Failed to respond to %s: %s", method, error->message);
+  }
+}
+
+static void switched_cb(FocusSwitcher *switcher, gint target, gint previous,
+                        gpointer user_data)
+{
+  SessionSnapshot *self = SESSION_SNAPSHOT(user_data);
+  self->current.active_target = target;
+  self->current.target_count =
+      focus_switcher_get_target_count(self->switcher);
+  commit(self);
+}
+
+void session_snapshot_discard(SessionSnapshot *self)
+{
+  g_return_if_fail(SESSION_IS_SNAPSHOT(self));
+  g_clear_handle_id(&self->stamp_source, g_source_remove);
+  if (self->file == nullptr)
+  {
+    return;
+  }
+
+  // Without the magic the next run starts from an empty file.
+  memset(self->file, 0, sizeof(SnapshotFile));
+  msync(self->file, sizeof(SnapshotFile), MS_SYNC);
+}
+
+// Implements GObject::dispose.
+static void session_snapshot_dispose(GObject *object)
+{
+  SessionSnapshot *self = SESSION_SNAPSHOT(object);
+
+  g_clear_handle_id(&self->stamp_source, g_source_remove);
+  if (self->file != nullptr)
+  {
+    munmap(self->file, sizeof(SnapshotFile));
+    self->file = nullptr;
+  }
+  if (self->fd >= 0)
+  {
+    close(self->fd);
+    self->fd = -1;
+  }
+  if (self->switcher != nullptr)
+  {
+    g_signal_handlers_disconnect_by_data(self->switcher, self);
+  }
+  g_clear_object(&self->switcher);
+
+  if (self->channel != nullptr)
+  {
+    fl_method_channel_set_method_call_handler(self->channel, nullptr, nullptr,
+                                              nullptr);
+  }
+  g_clear_object(&self->channel);
+
+  G_OBJECT_CLASS(session_snapshot_parent_class)->dispose(object);
+}
+
+static void session_snapshot_class_init(SessionSnapshotClass *klass)
+{
+  G_OBJECT_CLASS(klass)->dispose = session_snapshot_dispose;
+}
+
+static void session_snapshot_init(SessionSnapshot *self)
+{
+  self->fd = -1;
+}
+
+SessionSnapshot *session_snapshot_new(FlBinaryMessenger *messenger,
+                                      FocusSwitcher *switcher)
+{
+  SessionSnapshot *self =
+      SESSION_SNAPSHOT(g_object_new(session_snapshot_get_type(), nullptr));
+  self->switcher = FOCUS_SWITCHER(g_object_ref(switcher));
+  read_boot_id(self);
+
+  if (map_file(self))
+  {
+    self->has_restored = load(self);
+    if (self->has_restored)
+    {
+      focus_switcher_restore(switcher, self->restored.target_count,
+                             self->restored.active_target);
+
+      // Keep the peers until Dart re-adopts them, in case this run dies
+      // too.
+      self->current = self->restored;
+    }
+    else
+    {
+      memset(self->file, 0, sizeof(SnapshotFile));
+      self->file->magic = kMagic;
+      self->file->layout_version = kLayoutVersion;
+      self->file->slot_size = sizeof(SnapshotSlot);
+    }
+    commit(self);
+    self->stamp_source = g_timeout_add_seconds(kStampIntervalS, stamp_cb, self);
+  }
+
+  g_signal_connect(switcher, "switched", G_CALLBACK(switched_cb), self);
+
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  self->channel = fl_method_channel_new(messenger, "desk_switch/session",
+                                        FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(self->channel, method_call_cb,
+                                            self, nullptr);
+  return self;
+}
@@ -0,0 +1,44 @@
+#ifndef FLUTTER_SESSION_SNAPSHOT_H_
+#define FLUTTER_SESSION_SNAPSHOT_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <gtk/gtk.h>
+
+#include "focus_switcher.h"
+
+G_DECLARE_FINAL_TYPE(SessionSnapshot, session_snapshot, SESSION, SNAPSHOT,
+                     GObject)
+
+/**
+ * session_snapshot_new:
+ * @messenger: the engine's binary messenger.
+ * @switcher: the #FocusSwitcher whose active target is recorded.
+ *
+ * Maps the session snapshot file in the user's runtime directory. Peers,
+ * session IDs and keys, resume sequence numbers and the active target are
+ * written to it on every change and re-stamped periodically, so they
+ * outlive a crash or restart of this process. Focus switches are followed
+ * through the switcher's `switched` signal.
+ *
+ * If an earlier run of this boot left a valid snapshot behind, and it is
+ * recent enough for the peers to still hold the sessions, the focus
+ * switcher's targets are restored right away. Dart then fetches
+ * the peers over the `desk_switch/session` method channel to re-adopt the
+ * sessions.
+ *
+ * Returns: a new #SessionSnapshot.
+ */
+SessionSnapshot* session_snapshot_new(FlBinaryMessenger* messenger,
+                                      FocusSwitcher* switcher);
+
+/**
+ * session_snapshot_discard:
+ * @snapshot: a #SessionSnapshot.
+ *
+ * Empties the snapshot file when the user quits, so that the next run
+ * starts a new session instead of resuming this one. Other exits keep it
+ * for the next run.
+ */
+void session_snapshot_discard(SessionSnapshot* snapshot);
+
+#endif  // FLUTTER_SESSION_SNAPSHOT_H_
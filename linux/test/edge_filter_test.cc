@@ -0,0 +1,121 @@
+#include "edge_filter.h"
+
+// Milliseconds between the hits of a steady push.
+static const guint kStepMs = 10;
+
+static EdgeFilter new_filter(gint side)
+{
+  EdgeFilter filter = {};
+  filter.side = side;
+  return filter;
+}
+
+// Pushes right at 0.5 px/ms until the edge is crossed; returns the number
+// of hits it took, or 0 if it never crossed.
+static guint push_right(EdgeFilter *filter, guint event_id, guint *time,
+                        guint max_hits)
+{
+  for (guint hit = 1; hit <= max_hits; hit++)
+  {
+    *time += kStepMs;
+    if (edge_filter_hit(filter, event_id, *time, 5, 0, kStepMs, nullptr))
+    {
+      return hit;
+    }
+  }
+  return 0;
+}
+
+static void test_crosses_after_enough_pressure()
+{
+  EdgeFilter filter = new_filter(EDGE_SIDE_RIGHT);
+  guint time = 0;
+
+  // 24 px of pressure at 5 px per hit.
+  g_assert_cmpuint(push_right(&filter, 1, &time, 10), ==, 5);
+  g_assert_cmpfloat(filter.pressure, ==, 0);
+}
+
+static void test_reports_velocity()
+{
+  EdgeFilter filter = new_filter(EDGE_SIDE_LEFT);
+  gdouble velocity = 0;
+
+  edge_filter_hit(&filter, 1, 10, -8, 3, 4, &velocity);
+  g_assert_cmpfloat_with_epsilon(velocity, 2.0, 1e-9);
+}
+
+static void test_ignores_slow_pushes()
+{
+  EdgeFilter filter = new_filter(EDGE_SIDE_BOTTOM);
+
+  // 1 px per 10 ms is below the crossing velocity.
+  for (guint i = 1; i <= 100; i++)
+  {
+    g_assert_false(edge_filter_hit(&filter, 1, i * kStepMs, 0, 1, kStepMs,
+                                   nullptr));
+  }
+  g_assert_cmpfloat(filter.pressure, ==, 0);
+}
+
+static void test_ignores_motion_along_or_away_from_the_edge()
+{
+  EdgeFilter filter = new_filter(EDGE_SIDE_TOP);
+
+  for (guint i = 1; i <= 20; i++)
+  {
+    g_assert_false(edge_filter_hit(&filter, 1, i * kStepMs, 50, 0, kStepMs,
+                                   nullptr));
+    g_assert_false(edge_filter_hit(&filter, 1, i * kStepMs, 0, 50, kStepMs,
+                                   nullptr));
+  }
+  g_assert_cmpfloat(filter.pressure, ==, 0);
+}
+
+static void test_new_event_id_starts_a_new_push()
+{
+  EdgeFilter filter = new_filter(EDGE_SIDE_RIGHT);
+  guint time = 0;
+
+  g_assert_cmpuint(push_right(&filter, 1, &time, 4), ==, 0);
+  g_assert_cmpuint(push_right(&filter, 2, &time, 10), ==, 5);
+}
+
+static void test_pause_starts_a_new_push()
+{
+  EdgeFilter filter = new_filter(EDGE_SIDE_RIGHT);
+  guint time = 0;
+
+  g_assert_cmpuint(push_right(&filter, 1, &time, 4), ==, 0);
+  time += 200;
+  g_assert_cmpuint(push_right(&filter, 1, &time, 10), ==, 5);
+}
+
+static void test_leave_drops_the_push()
+{
+  EdgeFilter filter = new_filter(EDGE_SIDE_RIGHT);
+  guint time = 0;
+
+  g_assert_cmpuint(push_right(&filter, 1, &time, 4), ==, 0);
+  edge_filter_leave(&filter);
+  g_assert_cmpuint(push_right(&filter, 1, &time, 10), ==, 5);
+}
+
+int main(int argc, char **argv)
+{
+  g_test_init(&argc, &argv, nullptr);
+  g_test_add_func("/edge-filter/crosses-after-enough-pressure",
+                  test_crosses_after_enough_pressure);
+  g_test_add_func("/edge-filter/reports-velocity", test_reports_velocity);
+  g_test_add_func("/edge-filter/ignores-slow-pushes",
+                  test_ignores_slow_pushes);
+  g_test_add_func("/edge-filter/ignores-motion-along-or-away-from-the-edge",
+                  test_ignores_motion_along_or_away_from_the_edge);
+  g_test_add_func("/edge-filter/new-event-id-starts-a-new-push",
+                  test_new_event_id_starts_a_new_push);
+  g_test_add_func("/edge-filter/pause-starts-a-new-push",
+                  test_pause_starts_a_new_push);
+  g_test_add_func("/edge-filter/leave-drops-the-push",
+                  test_leave_drops_the_push);
+  return g_test_run();
+}
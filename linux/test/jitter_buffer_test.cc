@@ -0,0 +1,183 @@
+#include "jitter_buffer.h"
+
+static const guint kFrameMs = 10;
+
+// What pop() returned, as a sequence number or one of these.
+static const gint kLost = -1;
+static const gint kEmpty = -2;
+
+static JitterBuffer *new_buffer()
+{
+  return jitter_buffer_new(kFrameMs, 2, 20);
+}
+
+// Arrives exactly on the sender's clock, so jitter stays at zero.
+static void push(JitterBuffer *buffer, guint32 sequence)
+{
+  guint8 data = sequence & 0xff;
+  g_autoptr(GBytes) payload = g_bytes_new(&data, sizeof(data));
+  jitter_buffer_push(buffer, sequence, payload,
+                     static_cast<gint64>(sequence) * kFrameMs * 1000);
+}
+
+static gint pop(JitterBuffer *buffer)
+{
+  g_autoptr(GBytes) payload = nullptr;
+  switch (jitter_buffer_pop(buffer, &payload))
+  {
+  case JITTER_BUFFER_FRAME:
+  {
+    gsize size = 0;
+    const guint8 *data =
+        static_cast<const guint8 *>(g_bytes_get_data(payload, &size));
+    g_assert_cmpuint(size, ==, 1);
+    return data[0];
+  }
+  case JITTER_BUFFER_LOST:
+    return kLost;
+  case JITTER_BUFFER_EMPTY:
+    return kEmpty;
+  }
+  g_assert_not_reached();
+}
+
+static void test_reorders()
+{
+  g_autoptr(JitterBuffer) buffer = new_buffer();
+  push(buffer, 0);
+  push(buffer, 2);
+  push(buffer, 1);
+
+  g_assert_cmpint(pop(buffer), ==, 0);
+  g_assert_cmpint(pop(buffer), ==, 1);
+  g_assert_cmpint(pop(buffer), ==, 2);
+}
+
+static void test_waits_for_target_depth()
+{
+  g_autoptr(JitterBuffer) buffer = new_buffer();
+  push(buffer, 0);
+  g_assert_cmpint(pop(buffer), ==, kEmpty);
+
+  push(buffer, 1);
+  g_assert_cmpint(pop(buffer), ==, 0);
+}
+
+static void test_drops_duplicates()
+{
+  g_autoptr(JitterBuffer) buffer = new_buffer();
+  push(buffer, 0);
+  push(buffer, 0);
+  push(buffer, 1);
+
+  JitterBufferStats stats;
+  jitter_buffer_get_stats(buffer, &stats);
+  g_assert_cmpuint(stats.depth, ==, 2);
+
+  g_assert_cmpint(pop(buffer), ==, 0);
+  g_assert_cmpint(pop(buffer), ==, 1);
+  g_assert_cmpint(pop(buffer), ==, kEmpty);
+}
+
+static void test_drops_late_packets()
+{
+  g_autoptr(JitterBuffer) buffer = new_buffer();
+  push(buffer, 0);
+  push(buffer, 1);
+  g_assert_cmpint(pop(buffer), ==, 0);
+  g_assert_cmpint(pop(buffer), ==, 1);
+
+  push(buffer, 0);
+
+  JitterBufferStats stats;
+  jitter_buffer_get_stats(buffer, &stats);
+  g_assert_cmpuint(stats.late, ==, 1);
+  g_assert_cmpuint(stats.depth, ==, 0);
+}
+
+static void test_conceals_missing_frames()
+{
+  g_autoptr(JitterBuffer) buffer = new_buffer();
+  push(buffer, 0);
+  push(buffer, 2);
+
+  g_assert_cmpint(pop(buffer), ==, 0);
+  g_assert_cmpint(pop(buffer), ==, kLost);
+  g_assert_cmpint(pop(buffer), ==, 2);
+
+  JitterBufferStats stats;
+  jitter_buffer_get_stats(buffer, &stats);
+  g_assert_cmpuint(stats.lost, ==, 1);
+}
+
+static void test_drops_frames_on_overflow()
+{
+  g_autoptr(JitterBuffer) buffer = new_buffer();
+  push(buffer, 0);
+  push(buffer, 1);
+
+  // Further ahead than the ring holds: everything buffered is dropped and
+  // playout restarts from the new packet.
+  push(buffer, 1000);
+
+  JitterBufferStats stats;
+  jitter_buffer_get_stats(buffer, &stats);
+  g_assert_cmpuint(stats.depth, ==, 1);
+
+  g_assert_cmpint(pop(buffer), ==, kEmpty);
+  push(buffer, 1001);
+  g_assert_cmpint(pop(buffer), ==, 1000 & 0xff);
+  g_assert_cmpint(pop(buffer), ==, 1001 & 0xff);
+}
+
+static void test_underrun_raises_target()
+{
+  g_autoptr(JitterBuffer) buffer = new_buffer();
+  push(buffer, 0);
+  push(buffer, 1);
+  g_assert_cmpint(pop(buffer), ==, 0);
+  g_assert_cmpint(pop(buffer), ==, 1);
+  g_assert_cmpint(pop(buffer), ==, kEmpty);
+
+  JitterBufferStats stats;
+  jitter_buffer_get_stats(buffer, &stats);
+  g_assert_cmpuint(stats.underruns, ==, 1);
+  g_assert_cmpuint(stats.target, ==, 3);
+}
+
+static void test_reset_accepts_a_new_sender()
+{
+  g_autoptr(JitterBuffer) buffer = new_buffer();
+  push(buffer, 50);
+  push(buffer, 51);
+  g_assert_cmpint(pop(buffer), ==, 50);
+
+  jitter_buffer_reset(buffer);
+  push(buffer, 0);
+  push(buffer, 1);
+  g_assert_cmpint(pop(buffer), ==, 0);
+
+  JitterBufferStats stats;
+  jitter_buffer_get_stats(buffer, &stats);
+  g_assert_cmpuint(stats.late, ==, 0);
+}
+
+int main(int argc, char **argv)
+{
+  g_test_init(&argc, &argv, nullptr);
+  g_test_add_func("/jitter-buffer/reorders", test_reorders);
+  g_test_add_func("/jitter-buffer/waits-for-target-depth",
+                  test_waits_for_target_depth);
+  g_test_add_func("/jitter-buffer/drops-duplicates", test_drops_duplicates);
+  g_test_add_func("/jitter-buffer/drops-late-packets",
+                  test_drops_late_packets);
+  g_test_add_func("/jitter-buffer/conceals-missing-frames",
+                  test_conceals_missing_frames);
+  g_test_add_func("/jitter-buffer/drops-frames-on-overflow",
+                  test_drops_frames_on_overflow);
+  g_test_add_func("/jitter-buffer/underrun-raises-target",
+                  test_underrun_raises_target);
+  g_test_add_func("/jitter-buffer/reset-accepts-a-new-sender",
+                  test_reset_accepts_a_new_sender);
+  return g_test_run();
+}
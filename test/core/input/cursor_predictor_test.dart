@@ -0,0 +1,107 @@
+import 'package:desk_switch/core/input/cursor_predictor.dart';
+import 'package:desk_switch/core/input/input_message.dart';
+import 'package:flutter_test/flutter_test.dart';
+
+PointerFrame _frame(
+  int timestampUs,
+  double x, {
+  InputMessageType type = InputMessageType.pointerMotion,
+}) {
+  return PointerFrame(
+    type: type,
+    sequence: 0,
+    timestampUs: timestampUs,
+    x: x,
+    y: 0,
+  );
+}
+
+void main() {
+  group('CursorPredictor', () {
+    late CursorPredictor predictor;
+
+    setUp(() {
+      predictor = CursorPredictor(velocitySmoothing: 1);
+    });
+
+    test('extrapolates up to maxExtrapolation along the velocity', () {
+      predictor
+        ..addFrame(_frame(0, 0), 0)
+        ..addFrame(_frame(10000, 10), 10000);
+
+      // 1 px/ms for 80 ms past the last frame; the blend has long decayed
+      expect(predictor.predict(1000000).dx, closeTo(90, 0.01));
+      expect(predictor.isSettling(1000000), isFalse);
+    });
+
+    test('a correction during motion keeps extrapolating', () {
+      predictor
+        ..addFrame(_frame(0, 0), 0)
+        ..addFrame(_frame(10000, 10), 10000)
+        ..addFrame(
+          _frame(10000, 10, type: InputMessageType.pointerCorrection),
+          10000,
+        );
+
+      expect(predictor.isSettling(20000), isTrue);
+      expect(predictor.predict(1000000).dx, closeTo(90, 0.01));
+    });
+
+    test('a correction blends towards the authoritative position', () {
+      predictor
+        ..addFrame(_frame(0, 0), 0)
+        ..addFrame(_frame(10000, 10), 10000);
+      final before = predictor.predict(10000);
+
+      predictor.addFrame(
+        _frame(10000, 14, type: InputMessageType.pointerCorrection),
+        10000,
+      );
+
+      expect(predictor.predict(10000).dx, closeTo(before.dx, 0.01));
+      expect(predictor.predict(1000000).dx, closeTo(94, 0.01));
+    });
+
+    test('a correction after the pointer settles stops it', () {
+      predictor
+        ..addFrame(_frame(0, 0), 0)
+        ..addFrame(_frame(10000, 10), 10000)
+        ..addFrame(
+          _frame(50000, 10, type: InputMessageType.pointerCorrection),
+          50000,
+        );
+
+      expect(predictor.predict(1000000).dx, closeTo(10, 0.01));
+      expect(predictor.isSettling(1000000), isFalse);
+    });
+
+    test('records the error of predictions that came due', () {
+      predictor
+        ..addFrame(_frame(0, 0), 0)
+        ..predict(0)
+        ..addFrame(_frame(30000, 5), 30000);
+
+      expect(predictor.stats.count, 1);
+      expect(predictor.stats.max, closeTo(5, 0.01));
+    });
+  });
+
+  group('PredictionStats', () {
+    test('quantile returns the upper bound of its bucket', () {
+      final stats = PredictionStats();
+      for (final error in [0.5, 1.5, 3.0, 3.5, 100.0]) {
+        stats.add(error);
+      }
+
+      expect(stats.quantile(0.2), 1);
+      expect(stats.quantile(0.5), 4);
+      expect(stats.quantile(0.8), 4);
+      expect(stats.quantile(1), 100);
+      expect(stats.buckets.last, 1);
+    });
+
+    test('quantile of an empty distribution is zero', () {
+      expect(PredictionStats().quantile(0.99), 0);
+    });
+  });
+}
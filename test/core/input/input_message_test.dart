@@ -0,0 +1,104 @@
+import 'dart:typed_data';
+
+import 'package:desk_switch/core/input/input_message.dart';
+import 'package:flutter_test/flutter_test.dart';
+
+void main() {
+  group('PointerFrame', () {
+    test('round-trips through its encoding', () {
+      const frame = PointerFrame(
+        type: InputMessageType.pointerCorrection,
+        sequence: 0xfffffffe,
+        timestampUs: 1 << 40,
+        x: 1919.5,
+        y: -3.25,
+      );
+      final data = frame.encode();
+      final decoded = PointerFrame.decode(data)!;
+
+      expect(data.length, PointerFrame.encodedSize);
+      expect(InputMessageType.of(data), InputMessageType.pointerCorrection);
+      expect(decoded.isCorrection, isTrue);
+      expect(decoded.sequence, frame.sequence);
+      expect(decoded.timestampUs, frame.timestampUs);
+      expect(decoded.x, frame.x);
+      expect(decoded.y, frame.y);
+    });
+
+    test('rejects other message types and short frames', () {
+      final data = const PointerFrame(
+        type: InputMessageType.pointerMotion,
+        sequence: 1,
+        timestampUs: 2,
+        x: 3,
+        y: 4,
+      ).encode();
+
+      expect(PointerFrame.decode(Uint8List.sublistView(data, 0, 20)), isNull);
+      expect(PointerFrame.decode(Uint8List(0)), isNull);
+      expect(
+        PointerFrame.decode(
+          Uint8List.fromList([InputMessageType.scroll.index, ...data.skip(1)]),
+        ),
+        isNull,
+      );
+    });
+  });
+
+  group('ScrollFrame', () {
+    test('round-trips through its encoding', () {
+      const frame = ScrollFrame(dx: -45, dy: 360, durationUs: 8000);
+      final data = frame.encode();
+      final decoded = ScrollFrame.decode(data)!;
+
+      expect(data.length, ScrollFrame.encodedSize);
+      expect(InputMessageType.of(data), InputMessageType.scroll);
+      expect(decoded.dx, frame.dx);
+      expect(decoded.dy, frame.dy);
+      expect(decoded.durationUs, frame.durationUs);
+    });
+
+    test('clamps values that do not fit the wire format', () {
+      final decoded = ScrollFrame.decode(
+        const ScrollFrame(dx: -100000, dy: 100000, durationUs: -1).encode(),
+      )!;
+
+      expect(decoded.dx, -0x8000);
+      expect(decoded.dy, 0x7fff);
+      expect(decoded.durationUs, 0);
+    });
+
+    test('rejects other message types and short frames', () {
+      final data = const ScrollFrame(dx: 1, dy: 2, durationUs: 3).encode();
+
+      expect(ScrollFrame.decode(Uint8List.sublistView(data, 0, 6)), isNull);
+      expect(
+        ScrollFrame.decode(
+          Uint8List.fromList([
+            InputMessageType.screenSize.index,
+            ...data.skip(1),
+          ]),
+        ),
+        isNull,
+      );
+    });
+  });
+
+  group('FocusFrame', () {
+    test('round-trips both states', () {
+      for (final focused in [true, false]) {
+        final data = FocusFrame(focused: focused).encode();
+
+        expect(data.length, FocusFrame.encodedSize);
+        expect(FocusFrame.decode(data)!.focused, focused);
+      }
+    });
+
+    test('is not mistaken for a scroll frame', () {
+      final data = const FocusFrame(focused: true).encode();
+
+      expect(ScrollFrame.decode(data), isNull);
+      expect(FocusFrame.decode(Uint8List.sublistView(data, 0, 1)), isNull);
+    });
+  });
+}
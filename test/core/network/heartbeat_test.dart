@@ -0,0 +1,87 @@
+import 'dart:async';
+
+import 'package:desk_switch/core/network/heartbeat.dart';
+import 'package:flutter_test/flutter_test.dart';
+
+const _ms = Duration(milliseconds: 1);
+
+void main() {
+  group('Heartbeat', () {
+    late List<Duration> pings;
+    late Completer<void> enoughPings;
+    late int wantedPings;
+    late int timeouts;
+    late Heartbeat heartbeat;
+
+    Heartbeat create({bool echo = true}) {
+      return Heartbeat(
+        sendPing: (nextPing) {
+          pings.add(nextPing);
+          if (echo) {
+            heartbeat.notifyReceived();
+          }
+          if (pings.length == wantedPings) {
+            enoughPings.complete();
+          }
+        },
+        onTimeout: () => timeouts++,
+        activeInterval: _ms * 10,
+        maxIdleInterval: _ms * 40,
+      );
+    }
+
+    setUp(() {
+      pings = [];
+      enoughPings = Completer();
+      wantedPings = 3;
+      timeouts = 0;
+    });
+
+    tearDown(() => heartbeat.stop());
+
+    test('pings at the active interval', () async {
+      heartbeat = create()..start();
+      await enoughPings.future;
+
+      expect(pings, [_ms * 10, _ms * 10, _ms * 10]);
+      expect(timeouts, 0);
+    });
+
+    test('doubles the interval while idle, up to the maximum', () async {
+      heartbeat = create()
+        // The peer announced a long interval, so silence is expected
+        ..notifyPing(const Duration(seconds: 1))
+        ..setIdle(true)
+        ..start();
+      await enoughPings.future;
+
+      expect(pings, [_ms * 20, _ms * 40, _ms * 40]);
+      expect(heartbeat.interval, _ms * 40);
+    });
+
+    test('goes back to the active interval on activity', () async {
+      wantedPings = 2;
+      heartbeat = create()
+        ..notifyPing(const Duration(seconds: 1))
+        ..setIdle(true)
+        ..start();
+      await enoughPings.future;
+
+      heartbeat.setIdle(false);
+
+      expect(pings.last, _ms * 10);
+      expect(pings, hasLength(3));
+      expect(heartbeat.interval, _ms * 10);
+    });
+
+    test('times out after the peer misses its pings', () async {
+      heartbeat = create(echo: false)..start();
+      await Future<void>.delayed(_ms * 150);
+
+      expect(timeouts, 1);
+      expect(heartbeat.isRunning, isFalse);
+      expect(pings, isNotEmpty);
+      expect(pings, everyElement(_ms * 10));
+    });
+  });
+}
@@ -0,0 +1,145 @@
+import 'dart:typed_data';
+
+import 'package:desk_switch/core/network/stream_multiplexer.dart';
+import 'package:flutter_test/flutter_test.dart';
+
+void main() {
+  group('StreamMultiplexer', () {
+    late List<Uint8List> wire;
+    late StreamMultiplexer sender;
+    late StreamMultiplexer receiver;
+
+    setUp(() {
+      wire = [];
+      receiver = StreamMultiplexer(
+        send: (frame) => sender.handleFrame(frame),
+        isInitiator: false,
+      );
+      sender = StreamMultiplexer(
+        send: (frame) {
+          wire.add(frame);
+          receiver.handleFrame(frame);
+        },
+        isInitiator: true,
+        maxChunkSize: 1024,
+      );
+    });
+
+    test('reassembles chunked messages', () async {
+      final received = <MuxMessage>[];
+      receiver.messages.listen(received.add);
+
+      final payload = Uint8List.fromList(
+        List.generate(5000, (i) => i & 0xff),
+      );
+      sender.send(StreamPriority.bulk, payload);
+      await pumpEventQueue();
+
+      expect(received, hasLength(1));
+      expect(received.single.priority, StreamPriority.bulk);
+      expect(received.single.data, payload);
+      expect(wire.length, greaterThan(1));
+    });
+
+    test('input overtakes a bulk transfer in progress', () async {
+      final received = <StreamPriority>[];
+      receiver.messages.listen((message) => received.add(message.priority));
+
+      sender.send(StreamPriority.bulk, Uint8List(64 * 1024));
+      sender.sendString(StreamPriority.input, 'key');
+      await pumpEventQueue();
+
+      expect(received, [StreamPriority.input, StreamPriority.bulk]);
+    });
+
+    test('stops at the flow-control window until credit returns', () async {
+      final blocked = StreamMultiplexer(
+        send: wire.add,
+        isInitiator: true,
+        maxChunkSize: 1024,
+      );
+
+      blocked.send(
+        StreamPriority.bulk,
+        Uint8List(StreamPriority.bulk.initialWindow * 2),
+      );
+      await pumpEventQueue();
+
+      final sent = wire.fold<int>(
+        0,
+        (sum, frame) => sum + frame.length - StreamMultiplexer.headerSize,
+      );
+      expect(sent, StreamPriority.bulk.initialWindow);
+    });
+
+    test('drops a peer whose message outgrows the limit', () async {
+      final violations = <String>[];
+      final limited = StreamMultiplexer(
+        send: (_) {},
+        isInitiator: false,
+        onViolation: violations.add,
+        maxMessageSize: 4096,
+      );
+      final peer = StreamMultiplexer(
+        send: limited.handleFrame,
+        isInitiator: true,
+        maxChunkSize: 1024,
+      );
+
+      peer.send(StreamPriority.bulk, Uint8List(8192));
+      await pumpEventQueue();
+
+      expect(violations, hasLength(1));
+    });
+
+    test('drops a peer that opens too many streams', () async {
+      final violations = <String>[];
+      final limited = StreamMultiplexer(
+        send: (_) {},
+        isInitiator: false,
+        onViolation: violations.add,
+        maxPeerStreams: 2,
+      );
+      final peer = StreamMultiplexer(
+        send: limited.handleFrame,
+        isInitiator: true,
+      );
+
+      for (var i = 0; i < 3; i++) {
+        peer.openStream(StreamPriority.bulk).send([i]);
+      }
+      await pumpEventQueue();
+
+      expect(violations, hasLength(1));
+    });
+
+    test('decodes malformed control text without throwing', () {
+      final message = MuxMessage(
+        streamId: StreamPriority.control.index,
+        priority: StreamPriority.control,
+        data: Uint8List.fromList([0x68, 0xff, 0x69]),
+      );
+
+      expect(message.text, 'h\ufffdi');
+    });
+
+    test('opened streams never collide with each other or defaults', () {
+      final initiated = [
+        for (var i = 0; i < 3; i++) sender.openStream(StreamPriority.bulk).id,
+      ];
+      final accepted = [
+        for (var i = 0; i < 3; i++)
+          receiver.openStream(StreamPriority.bulk).id,
+      ];
+
+      expect(initiated.every((id) => id.isOdd), isTrue);
+      expect(accepted.every((id) => id.isEven), isTrue);
+      expect(
+        [...initiated, ...accepted],
+        everyElement(
+          greaterThanOrEqualTo(StreamMultiplexer.reservedStreamIds),
+        ),
+      );
+    });
+  });
+}
@@ -0,0 +1,66 @@
+import 'package:desk_switch/core/utils/keyed_change_log.dart';
+import 'package:flutter_test/flutter_test.dart';
+
+void main() {
+  group('KeyedChangeLog', () {
+    late KeyedChangeLog<String> log;
+
+    setUp(() {
+      log = KeyedChangeLog();
+    });
+
+    test('starts each subscriber with a snapshot, then deltas', () async {
+      log
+        ..put('a', 'alpha')
+        ..put('b', 'beta');
+
+      final received = <KeyedChange<String>>[];
+      log.changes().listen(received.add);
+      await pumpEventQueue();
+
+      log
+        ..put('a', 'ALPHA')
+        ..remove('b')
+        ..put('c', 'gamma');
+      await pumpEventQueue();
+
+      expect(received.first, isA<KeyedSnapshot<String>>());
+      expect((received.first as KeyedSnapshot<String>).items, {
+        'a': 'alpha',
+        'b': 'beta',
+      });
+      expect(received.skip(1).map((change) => change.runtimeType), [
+        KeyedUpdated<String>,
+        KeyedRemoved<String>,
+        KeyedAdded<String>,
+      ]);
+      expect(received.map((change) => change.version), [2, 3, 4, 5]);
+    });
+
+    test('a view replays to the same contents', () async {
+      final view = KeyedView<String>(where: (key) => key != 'self');
+      log.changes().listen(view.apply);
+      await pumpEventQueue();
+
+      log
+        ..put('self', 'ignored')
+        ..put('a', 'alpha')
+        ..put('b', 'beta')
+        ..put('a', 'ALPHA')
+        ..remove('b');
+      await pumpEventQueue();
+
+      expect(view.keys, ['a']);
+      expect(view['a'], 'ALPHA');
+      expect(view.version, log.version);
+    });
+
+    test('a view ignores stale changes', () {
+      final view = KeyedView<String>()
+        ..apply(const KeyedSnapshot(5, {'a': 'alpha'}));
+
+      expect(view.apply(const KeyedRemoved(4, 'a')), isFalse);
+      expect(view['a'], 'alpha');
+    });
+  });
+}
@@ -0,0 +1,123 @@
+import 'dart:ui';
+
+import 'package:desk_switch/core/services/edge_barrier_service.dart';
+import 'package:desk_switch/features/home/widgets/arrange_displays_dialog.dart';
+import 'package:flutter_test/flutter_test.dart';
+
+KvmDisplay _display(
+  String id,
+  double x,
+  double y,
+  double width,
+  double height,
+) {
+  return KvmDisplay(
+    id: id,
+    name: id,
+    position: Offset(x, y),
+    size: Size(width, height),
+  );
+}
+
+void main() {
+  group('KvmDisplayArrangement.adjacentEdges', () {
+    test('finds a neighbour on each side', () {
+      final arrangement = KvmDisplayArrangement(
+        displays: [
+          _display('local', 0, 0, 100, 50),
+          _display('right', 100, 0, 100, 50),
+          _display('left', -80, 0, 80, 50),
+          _display('below', 0, 50, 100, 50),
+          _display('above', 0, -50, 100, 50),
+        ],
+      );
+
+      expect(arrangement.adjacentEdges('local'), [
+        (side: ScreenSide.right, start: 0.0, end: 1.0, target: 1),
+        (side: ScreenSide.left, start: 0.0, end: 1.0, target: 2),
+        (side: ScreenSide.bottom, start: 0.0, end: 1.0, target: 3),
+        (side: ScreenSide.top, start: 0.0, end: 1.0, target: 4),
+      ]);
+    });
+
+    test('limits each edge to the overlap with its neighbour', () {
+      final arrangement = KvmDisplayArrangement(
+        displays: [
+          _display('local', 0, 0, 100, 50),
+          // Lower half of the right side, hanging below the screen
+          _display('right', 100, 25, 100, 50),
+          // Left half of the top side, hanging past the left corner
+          _display('above', -50, -40, 100, 40),
+          // Middle of the bottom side
+          _display('below', 25, 50, 25, 30),
+        ],
+      );
+
+      expect(arrangement.adjacentEdges('local'), [
+        (side: ScreenSide.right, start: 0.5, end: 1.0, target: 1),
+        (side: ScreenSide.top, start: 0.0, end: 0.5, target: 2),
+        (side: ScreenSide.bottom, start: 0.25, end: 0.5, target: 3),
+      ]);
+    });
+
+    test('skips displays that only touch a corner or are apart', () {
+      final arrangement = KvmDisplayArrangement(
+        displays: [
+          _display('local', 0, 0, 100, 50),
+          _display('corner', 100, 50, 100, 50),
+          _display('apart', 150, 0, 100, 50),
+        ],
+      );
+
+      expect(arrangement.adjacentEdges('local'), isEmpty);
+    });
+
+    test('numbers targets in list order without the local display', () {
+      final arrangement = KvmDisplayArrangement(
+        displays: [
+          _display('left', -100, 0, 100, 50),
+          _display('local', 0, 0, 100, 50),
+          // Within the default tolerance of one pixel
+          _display('right', 101, 0, 100, 50),
+        ],
+      );
+
+      expect(
+        arrangement.adjacentEdges('local').map((edge) => edge.target),
+        [1, 2],
+      );
+      expect(arrangement.adjacentEdges('local', tolerance: 0), hasLength(1));
+    });
+  });
+
+  group('KvmDisplayArrangement.localId', () {
+    test('finds the display marked as local', () {
+      final arrangement = KvmDisplayArrangement(
+        displays: [
+          _display('remote', 100, 0, 100, 50),
+          KvmDisplay(
+            id: 'here',
+            name: 'here',
+            position: Offset.zero,
+            size: const Size(100, 50),
+            isLocal: true,
+          ),
+        ],
+      );
+
+      expect(arrangement.localId, 'here');
+      expect(
+        arrangement.updateDisplay('here', const Offset(0, 10)).localId,
+        'here',
+      );
+    });
+
+    test('is null without a local display', () {
+      final arrangement = KvmDisplayArrangement(
+        displays: [_display('remote', 0, 0, 100, 50)],
+      );
+
+      expect(arrangement.localId, isNull);
+    });
+  });
+}
@@ -0,0 +1,222 @@
+// ignore_for_file: avoid_print
+
+import 'dart:async';
+import 'dart:io';
+import 'dart:math' as math;
+
+import 'package:desk_switch/core/network/stream_multiplexer.dart';
+import 'package:desk_switch/core/services/server_service.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:hooks_riverpod/hooks_riverpod.dart';
+
+import 'simulated_client.dart';
+
+/// Load test for [ServerService] with simulated clients on loopback.
+///
+/// Skipped unless `DESK_SWITCH_LOAD_CLIENTS` is set, e.g.
+///
+/// ```bash
+/// DESK_SWITCH_LOAD_CLIENTS=1,10,50,100 flutter test test/load
+/// ```
+///
+/// Other knobs: `DESK_SWITCH_LOAD_RATE` (server input events/s, default
+/// 120), `DESK_SWITCH_LOAD_CLIENT_RATE` (control messages/s per client,
+/// default 10), `DESK_SWITCH_LOAD_SECONDS` (default 5) and
+/// `DESK_SWITCH_LOAD_RECORDING` (file of `<delay µs> <x> <y>` lines to
+/// replay instead of synthetic motion).
+///
+/// Clients live in the same process as the server, so memory and CPU
+/// figures include both ends; compare them across client counts rather
+/// than reading them as absolute server cost.
+void main() {
+  final env = Platform.environment;
+  final counts = env['DESK_SWITCH_LOAD_CLIENTS']
+      ?.split(',')
+      .map((count) => int.parse(count.trim()))
+      .toList();
+  final inputRate = double.parse(env['DESK_SWITCH_LOAD_RATE'] ?? '120');
+  final clientRate = double.parse(env['DESK_SWITCH_LOAD_CLIENT_RATE'] ?? '10');
+  final duration = Duration(
+    seconds: int.parse(env['DESK_SWITCH_LOAD_SECONDS'] ?? '5'),
+  );
+  final recording = env['DESK_SWITCH_LOAD_RECORDING'];
+
+  test(
+    'ServerService scales with attached clients',
+    () async {
+      print(
+        'clients | connect ms | notify | p50 µs | p99 µs | delivered/s '
+        '| server rx/s | KiB/client | cpu %',
+      );
+      for (final count in counts!) {
+        final result = await _run(
+          clients: count,
+          input: recording != null
+              ? recordedInput(File(recording))
+              : syntheticInput(inputRate),
+          clientRate: clientRate,
+          duration: duration,
+        );
+        print(result);
+        expect(result.delivered, greaterThan(0));
+        expect(result.dropped, 0, reason: 'clients lost during the run');
+      }
+    },
+    skip: counts == null ? 'Set DESK_SWITCH_LOAD_CLIENTS to run' : false,
+    timeout: const Timeout(Duration(minutes: 30)),
+  );
+}
+
+class _LoadResult {
+  _LoadResult({
+    required this.clients,
+    required this.connectTime,
+    required this.notifications,
+    required this.latenciesUs,
+    required this.delivered,
+    required this.serverReceived,
+    required this.dropped,
+    required this.elapsed,
+    required this.rssPerClient,
+    required this.cpuPercent,
+  });
+
+  final int clients;
+  final Duration connectTime;
+  final int notifications;
+  final List<int> latenciesUs;
+  final int delivered;
+  final int serverReceived;
+
+  /// Clients that timed out or were dropped by the server
+  final int dropped;
+  final Duration elapsed;
+  final double rssPerClient;
+  final double? cpuPercent;
+
+  int _percentile(double q) {
+    if (latenciesUs.isEmpty) {
+      return 0;
+    }
+    final sorted = [...latenciesUs]..sort();
+    return sorted[((sorted.length - 1) * q).round()];
+  }
+
+  @override
+  String toString() {
+    final seconds = elapsed.inMicroseconds / 1e6;
+    return [
+      '$clients'.padLeft(7),
+      '${connectTime.inMilliseconds}'.padLeft(10),
+      '$notifications'.padLeft(6),
+      '${_percentile(0.5)}'.padLeft(6),
+      '${_percentile(0.99)}'.padLeft(6),
+      (delivered / seconds).toStringAsFixed(0).padLeft(11),
+      (serverReceived / seconds).toStringAsFixed(0).padLeft(11),
+      (rssPerClient / 1024).toStringAsFixed(1).padLeft(10),
+      (cpuPercent?.toStringAsFixed(1) ?? '?').padLeft(5),
+    ].join(' | ');
+  }
+}
+
+Future<_LoadResult> _run({
+  required int clients,
+  required Iterable<InputSample> input,
+  required double clientRate,
+  required Duration duration,
+}) async {
+  final container = ProviderContainer();
+  final server = container.read(serverServiceProvider.notifier);
+  final info = await server.start();
+  final clock = Stopwatch()..start();
+
+  var notifications = 0;
+  final clientsSubscription = server.clientChanges().listen(
+    (_) => notifications++,
+  );
+  var serverReceived = 0;
+  final messagesSubscription = server.messages().listen(
+    (_) => serverReceived++,
+  );
+
+  // Attach all clients and wait until the server has registered them
+  final rssBefore = ProcessInfo.currentRss;
+  final connectWatch = Stopwatch()..start();
+  final simulated = [
+    for (var i = 0; i < clients; i++) SimulatedClient(i, clock),
+  ];
+  await Future.wait(simulated.map((client) => client.connect(info!.port!)));
+  if (server.clientCount < clients) {
+    await server.clientChanges().firstWhere(
+      (_) => server.clientCount >= clients,
+    );
+  }
+  connectWatch.stop();
+  final rssPerClient = (ProcessInfo.currentRss - rssBefore) / clients;
+
+  // Drive input through the broadcast path
+  for (final client in simulated) {
+    client
+      ..resetStats()
+      ..startSending(clientRate);
+  }
+  serverReceived = 0;
+  final cpuBefore = _cpuTime();
+  final driveWatch = Stopwatch()..start();
+  var sequence = 0;
+  for (final sample in input) {
+    if (driveWatch.elapsed >= duration) {
+      break;
+    }
+    await Future<void>.delayed(sample.delay);
+    server.sendData(
+      stampedFrame(clock, sequence++, sample.x, sample.y),
+      priority: StreamPriority.input,
+    );
+  }
+  // Let in-flight frames land before reading the counters
+  await Future<void>.delayed(const Duration(milliseconds: 200));
+  driveWatch.stop();
+  final cpuAfter = _cpuTime();
+
+  final result = _LoadResult(
+    clients: clients,
+    connectTime: connectWatch.elapsed,
+    notifications: notifications,
+    latenciesUs: [for (final client in simulated) ...client.latenciesUs],
+    delivered: simulated.fold(0, (sum, c) => sum + c.receivedMessages),
+    serverReceived: serverReceived,
+    dropped: math.max(
+      clients - server.clientCount,
+      simulated.where((client) => client.timedOut).length,
+    ),
+    elapsed: driveWatch.elapsed,
+    rssPerClient: rssPerClient,
+    cpuPercent: cpuBefore == null || cpuAfter == null
+        ? null
+        : (cpuAfter - cpuBefore).inMicroseconds /
+              driveWatch.elapsedMicroseconds *
+              100,
+  );
+
+  await Future.wait(simulated.map((client) => client.close()));
+  await clientsSubscription.cancel();
+  await messagesSubscription.cancel();
+  await server.stop();
+  container.dispose();
+  return result;
+}
+
+/// User plus system CPU time of this process (Linux only)
+Duration? _cpuTime() {
+  try {
+    final stat = File('/proc/self/stat').readAsStringSync();
+    // Fields after the parenthesised command name; utime and stime are
+    // fields 14 and 15 of the full line, in clock ticks (USER_HZ = 100)
+    final fields = stat.substring(stat.lastIndexOf(')') + 2).split(' ');
+    final ticks = int.parse(fields[11]) + int.parse(fields[12]);
+    return Duration(milliseconds: ticks * 10);
+  } on FileSystemException {
+    return null;
+  }
+}
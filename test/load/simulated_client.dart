@@ -0,0 +1,146 @@
+import 'dart:async';
+import 'dart:io';
+import 'dart:math' as math;
+import 'dart:typed_data';
+
+import 'package:desk_switch/core/input/input_message.dart';
+import 'package:desk_switch/core/network/heartbeat.dart';
+import 'package:desk_switch/core/network/stream_multiplexer.dart';
+
+/// A client peer simulated in-process over a loopback WebSocket.
+///
+/// It speaks the same multiplexed protocol as `ClientService`, heartbeat
+/// included, but keeps no Riverpod state, so hundreds of them can share one
+/// isolate. Pointer
+/// frames from the server are stamped with [clock] time on send; since
+/// sender and receiver share the clock, their age on arrival is the
+/// one-way delivery latency.
+class SimulatedClient {
+  SimulatedClient(this.id, this.clock);
+
+  final int id;
+  final Stopwatch clock;
+
+  final List<int> latenciesUs = [];
+  int receivedBytes = 0;
+  int receivedMessages = 0;
+
+  /// Whether the server went quiet for longer than its heartbeat allows
+  bool timedOut = false;
+
+  WebSocket? _socket;
+  StreamMultiplexer? _multiplexer;
+  Heartbeat? _heartbeat;
+  Timer? _sendTimer;
+
+  Future<void> connect(int port) async {
+    final socket = await WebSocket.connect('ws://127.0.0.1:$port');
+    late final Heartbeat heartbeat;
+    final multiplexer = StreamMultiplexer(
+      send: socket.add,
+      isInitiator: true,
+      onPing: (nextPing) => heartbeat.notifyPing(nextPing),
+    );
+    heartbeat = Heartbeat(
+      sendPing: multiplexer.sendPing,
+      onTimeout: () => timedOut = true,
+    );
+    multiplexer.messages.listen(_handleMessage);
+    socket.listen((data) {
+      heartbeat.notifyReceived();
+      if (data is List<int>) {
+        receivedBytes += data.length;
+        multiplexer.handleFrame(data);
+      }
+    });
+    _socket = socket;
+    _multiplexer = multiplexer;
+    _heartbeat = heartbeat..start();
+  }
+
+  /// Send a small control message to the server [rate] times per second
+  void startSending(double rate) {
+    if (rate <= 0) {
+      return;
+    }
+    final interval = Duration(microseconds: (1e6 / rate).round());
+    var sequence = 0;
+    _sendTimer = Timer.periodic(interval, (_) {
+      _multiplexer?.sendString(
+        StreamPriority.control,
+        '{"client":$id,"seq":${sequence++}}',
+      );
+    });
+  }
+
+  /// Forget everything measured so far
+  void resetStats() {
+    latenciesUs.clear();
+    receivedBytes = 0;
+    receivedMessages = 0;
+  }
+
+  Future<void> close() async {
+    _sendTimer?.cancel();
+    _heartbeat?.stop();
+    await _multiplexer?.close();
+    await _socket?.close();
+  }
+
+  void _handleMessage(MuxMessage message) {
+    receivedMessages++;
+    final frame = PointerFrame.decode(message.data);
+    if (frame != null) {
+      latenciesUs.add(clock.elapsedMicroseconds - frame.timestampUs);
+    }
+  }
+}
+
+/// One step of synthetic or recorded pointer input
+typedef InputSample = ({Duration delay, double x, double y});
+
+/// Endless circular pointer motion at [rate] events per second
+Iterable<InputSample> syntheticInput(double rate) sync* {
+  final delay = Duration(microseconds: (1e6 / rate).round());
+  for (var i = 0; ; i++) {
+    final angle = i / 60;
+    yield (
+      delay: delay,
+      x: 960 + 400 * math.cos(angle),
+      y: 540 + 400 * math.sin(angle),
+    );
+  }
+}
+
+/// Input recorded as lines of `<delay µs> <x> <y>`, replayed in a loop
+Iterable<InputSample> recordedInput(File recording) sync* {
+  final samples = [
+    for (final line in recording.readAsLinesSync())
+      if (line.trim().isNotEmpty)
+        switch (line.trim().split(RegExp(r'\s+'))) {
+          [final delay, final x, final y] => (
+            delay: Duration(microseconds: int.parse(delay)),
+            x: double.parse(x),
+            y: double.parse(y),
+          ),
+          _ => throw FormatException('Bad recording line: $line'),
+        },
+  ];
+  if (samples.isEmpty) {
+    return;
+  }
+  while (true) {
+    yield* samples;
+  }
+}
+
+/// Encode a pointer frame stamped with [clock] time
+Uint8List stampedFrame(Stopwatch clock, int sequence, double x, double y) {
+  return PointerFrame(
+    type: InputMessageType.pointerMotion,
+    sequence: sequence,
+    timestampUs: clock.elapsedMicroseconds,
+    x: x,
+    y: y,
+  ).encode();
+}